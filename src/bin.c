@@ -0,0 +1,74 @@
+/*** bin.c -- binary output records
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "bin.h"
+#include "nifty.h"
+
+#define BIN_VERSION	(1U)
+#define BIN_BOM		(0x01020304U)
+#if defined HAVE_DFP754_BID_LITERALS
+# define BIN_ENC	((uint32_t)'b')
+#elif defined HAVE_DFP754_DPD_LITERALS
+# define BIN_ENC	((uint32_t)'d')
+#endif	/* HAVE_DFP754_*_LITERALS */
+
+static const char magic[7U] = "\x7ftrufbn";
+
+
+void
+truf_bin_hdr(truf_wrr_t w, const char *cols, size_t recz)
+{
+	struct truf_bin_hdr_s h = {
+		.version = BIN_VERSION,
+		.bom = BIN_BOM,
+		.enc = BIN_ENC,
+		.recz = (uint32_t)recz,
+	};
+
+	memcpy(h.magic, magic, sizeof(magic));
+	memcpy(h.cols, cols, strnlen(cols, sizeof(h.cols)));
+	memcpy(truf_wrr_buf(w), &h, sizeof(h));
+	truf_wrr_adv(w, sizeof(h));
+	return;
+}
+
+/* bin.c ends here */
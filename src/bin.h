@@ -0,0 +1,95 @@
+/*** bin.h -- binary output records
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_bin_h_
+#define INCLUDED_bin_h_
+
+#include <stdint.h>
+#include "truffle.h"
+#include "wrr.h"
+
+/**
+ * Binary output (--binary) consists of a header followed by fixed-width
+ * records, one per line of text output.  The header names the columns
+ * and their types in COLS, e.g. "t:u64 sym:c16 bid:d64 ask:d64", and
+ * gives the size of a record in RECZ.  Types are u64 for instants (the
+ * u member of echs_instant_t, year in bits 48-63, month 40-47, day
+ * 32-39, hour 24-31, minute 16-23, second 10-15, millisecond 0-9),
+ * c16 for \nul-padded symbols, d64 and d32 for _Decimal64 and _Decimal32
+ * values, NaN denotes absent values.
+ *
+ * Like packed files, byte order and decimal encoding are those of the
+ * writing host and are recorded in the header. */
+struct truf_bin_hdr_s {
+	char magic[7U];
+	uint8_t version;
+	/* byte order mark */
+	uint32_t bom;
+	/* decimal encoding */
+	uint32_t enc;
+	/* record size */
+	uint32_t recz;
+	char cols[48U];
+};
+
+/* records as written by filter, glue and flow */
+struct truf_bin_step_s {
+	uint64_t t;
+	char sym[16U];
+	truf_price_t bid;
+	truf_price_t ask;
+	truf_expos_t old;
+	truf_expos_t new;
+};
+
+/* records as written by roll */
+struct truf_bin_roll_s {
+	uint64_t t;
+	truf_price_t prc;
+	truf_quant_t vol;
+	truf_quant_t opi;
+};
+
+#define TRUF_BIN_STEP_COLS	\
+	"t:u64 sym:c16 bid:d64 ask:d64 old:d32 new:d32"
+#define TRUF_BIN_ROLL_COLS	"t:u64 prc:d64 vol:d64 opi:d64"
+
+
+/**
+ * Write a header for records of size RECZ with columns COLS to W. */
+extern void truf_bin_hdr(truf_wrr_t w, const char *cols, size_t recz);
+
+#endif	/* INCLUDED_bin_h_ */
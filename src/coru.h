@@ -119,6 +119,9 @@ static __thread coru_t ____caller[CORU_DEPTH];
 		const void *TMP(res) = NULL;			\
 								\
 		if (check_cocore(x)) {				\
+			/* siblings share depths */	\
+			____caller[____cdepth] =		\
+				get_current_cocore();		\
 			____cdepth++;				\
 			TMP(res) = switch_cocore((x), ptr);	\
 			____cdepth--;				\
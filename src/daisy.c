@@ -95,7 +95,7 @@ daisy_to_instant(daisy_t dd)
 		m = md.m;
 		d = md.d;
 	}
-	return (echs_instant_t){y, m, d, ECHS_ALL_DAY};
+	return (echs_instant_t){.y = y, .m = m, .d = d, .H = ECHS_ALL_DAY};
 }
 
 /* standalone version and adapted to what make_cut() needs */
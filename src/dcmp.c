@@ -0,0 +1,520 @@
+/*** dcmp.c -- transparent decompression of input files
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#if defined USE_GZIP || defined USE_XZ || defined USE_ZSTD
+# define USE_DCMP
+# include <pthread.h>
+#endif	/* USE_GZIP || USE_XZ || USE_ZSTD */
+#if defined USE_GZIP
+# include <zlib.h>
+#endif	/* USE_GZIP */
+#if defined USE_XZ
+# include <lzma.h>
+#endif	/* USE_XZ */
+#if defined USE_ZSTD
+# include <zstd.h>
+#endif	/* USE_ZSTD */
+#include "dcmp.h"
+#include "nifty.h"
+
+typedef enum {
+	DCMP_NONE,
+	DCMP_GZIP,
+	DCMP_XZ,
+	DCMP_ZSTD,
+} dcmp_fmt_t;
+
+#if defined USE_DCMP
+/* size of the compressed and decompressed chunks */
+#define DCMP_BSZ	(256U * 1024U)
+
+struct dcmp_s {
+	struct dcmp_s *next;
+	/* the decompressed end that we hand out */
+	FILE *f;
+	/* the compressed source */
+	FILE *z;
+	/* write end of the pipe, F reads from the other end */
+	int fd;
+	dcmp_fmt_t fmt;
+	pthread_t th;
+	/* 0 if all went well, an errno value otherwise */
+	int err;
+	/* bytes sniffed off a pipe, they go before the rest of Z */
+	size_t npre;
+	char pre[8U];
+};
+
+/* currently open decompressors */
+static struct dcmp_s *dcmps;
+#endif	/* USE_DCMP */
+
+
+static dcmp_fmt_t
+dcmp_fmt(FILE *f, char b[static 8U], size_t *nb)
+{
+/* sniff F's magic bytes, nothing is consumed, unless F is a pipe in
+ * which case the bytes read are put into B and their number into NB */
+	static const struct {
+		const char *m;
+		size_t z;
+		dcmp_fmt_t fmt;
+	} mgc[] = {
+		{"\x1f\x8b", 2U, DCMP_GZIP},
+		{"\xfd" "7zXZ\0", 6U, DCMP_XZ},
+		{"\x28\xb5\x2f\xfd", 4U, DCMP_ZSTD},
+	};
+	size_t i, n;
+	off_t o;
+	int c;
+
+	*nb = 0U;
+	if ((c = getc(f)) == EOF) {
+		return DCMP_NONE;
+	}
+	ungetc(c, f);
+	for (i = 0U; i < countof(mgc) && (char)c != *mgc[i].m; i++);
+	if (LIKELY(i >= countof(mgc))) {
+		return DCMP_NONE;
+	} else if ((o = ftello(f)) < 0) {
+#if defined USE_DCMP
+		/* pipes and things, can't peek further than one byte,
+		 * so read the whole magic and keep it for the reader */
+		*nb = fread(b, 1U, mgc[i].z, f);
+		if (*nb < mgc[i].z || memcmp(b, mgc[i].m, mgc[i].z)) {
+			return DCMP_NONE;
+		}
+		return mgc[i].fmt;
+#else  /* !USE_DCMP */
+		/* we couldn't decompress it anyway, so read it as text */
+		return DCMP_NONE;
+#endif	/* USE_DCMP */
+	}
+	n = fread(b, 1U, mgc[i].z, f);
+	if (UNLIKELY(fseeko(f, o, SEEK_SET) < 0)) {
+		return DCMP_NONE;
+	} else if (n < mgc[i].z || memcmp(b, mgc[i].m, mgc[i].z)) {
+		return DCMP_NONE;
+	}
+	return mgc[i].fmt;
+}
+
+#if defined USE_DCMP
+static size_t
+dcmp_rd(struct dcmp_s *d, unsigned char *b, size_t z)
+{
+/* like fread() on D's source but with the sniffed bytes first,
+ * Z is always large enough to take all of them */
+	size_t n = d->npre;
+
+	memcpy(b, d->pre, n);
+	d->npre = 0U;
+	return n + fread(b + n, 1U, z - n, d->z);
+}
+
+static int
+dcmp_wr(int fd, const unsigned char *b, size_t z)
+{
+	for (ssize_t nwr; z > 0U; b += nwr, z -= nwr) {
+		if (LIKELY((nwr = write(fd, b, z)) >= 0)) {
+			;
+		} else if (errno == EINTR) {
+			nwr = 0;
+		} else {
+			/* reader's gone */
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int
+dcmp_cat(struct dcmp_s *d, unsigned char *ib)
+{
+/* no compression, just pass things on */
+	for (size_t nrd; (nrd = dcmp_rd(d, ib, DCMP_BSZ)) > 0U;) {
+		if (dcmp_wr(d->fd, ib, nrd) < 0) {
+			return 0;
+		}
+	}
+	return ferror(d->z) ? EIO : 0;
+}
+
+# if defined USE_GZIP
+static int
+dcmp_gz(struct dcmp_s *d, unsigned char *ib, unsigned char *ob)
+{
+	z_stream zs = {.zalloc = Z_NULL, .zfree = Z_NULL, .opaque = Z_NULL};
+	int ret = Z_OK;
+	int res = 0;
+
+	/* +32 to accept gzip and zlib headers */
+	if (UNLIKELY(inflateInit2(&zs, 15 + 32) != Z_OK)) {
+		return ENOMEM;
+	}
+	for (bool full = false;;) {
+		size_t nrd;
+
+		if (zs.avail_in || full) {
+			/* keep draining */
+			;
+		} else if ((nrd = dcmp_rd(d, ib, DCMP_BSZ)) > 0U) {
+			zs.next_in = ib;
+			zs.avail_in = nrd;
+		} else {
+			break;
+		}
+		if (ret == Z_STREAM_END && zs.avail_in) {
+			/* another gzip member */
+			inflateReset(&zs);
+		}
+		zs.next_out = ob;
+		zs.avail_out = DCMP_BSZ;
+		switch ((ret = inflate(&zs, Z_NO_FLUSH))) {
+		case Z_OK:
+		case Z_STREAM_END:
+		case Z_BUF_ERROR:
+			break;
+		default:
+			res = EIO;
+			goto out;
+		}
+		full = !zs.avail_out;
+		if (dcmp_wr(d->fd, ob, DCMP_BSZ - zs.avail_out) < 0) {
+			goto out;
+		}
+	}
+	if (ferror(d->z) || ret != Z_STREAM_END) {
+		/* read error or truncated */
+		res = EIO;
+	}
+out:
+	inflateEnd(&zs);
+	return res;
+}
+# endif	/* USE_GZIP */
+
+# if defined USE_XZ
+static int
+dcmp_xz(struct dcmp_s *d, unsigned char *ib, unsigned char *ob)
+{
+	lzma_stream xs = LZMA_STREAM_INIT;
+	lzma_action act = LZMA_RUN;
+	lzma_ret ret;
+	int res = 0;
+
+	if (UNLIKELY(lzma_stream_decoder(
+			     &xs, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK)) {
+		return ENOMEM;
+	}
+	for (bool full = false;; full = !xs.avail_out) {
+		size_t nrd;
+
+		if (xs.avail_in || full || act == LZMA_FINISH) {
+			/* keep draining */
+			;
+		} else if ((nrd = dcmp_rd(d, ib, DCMP_BSZ)) > 0U) {
+			xs.next_in = ib;
+			xs.avail_in = nrd;
+		} else if (ferror(d->z)) {
+			res = EIO;
+			goto out;
+		} else {
+			act = LZMA_FINISH;
+		}
+		xs.next_out = ob;
+		xs.avail_out = DCMP_BSZ;
+		ret = lzma_code(&xs, act);
+		if (dcmp_wr(d->fd, ob, DCMP_BSZ - xs.avail_out) < 0) {
+			goto out;
+		} else if (ret != LZMA_OK) {
+			break;
+		}
+	}
+	if (ret != LZMA_STREAM_END) {
+		/* corrupt or truncated */
+		res = EIO;
+	}
+out:
+	lzma_end(&xs);
+	return res;
+}
+# endif	/* USE_XZ */
+
+# if defined USE_ZSTD
+static int
+dcmp_zstd(struct dcmp_s *d, unsigned char *ib, unsigned char *ob)
+{
+	ZSTD_inBuffer in = {ib, 0U, 0U};
+	ZSTD_DStream *zs;
+	/* 0 means the last frame is complete */
+	size_t ret = 0U;
+	int res = 0;
+
+	if (UNLIKELY((zs = ZSTD_createDStream()) == NULL)) {
+		return ENOMEM;
+	}
+	(void)ZSTD_initDStream(zs);
+	for (bool full = false;;) {
+		ZSTD_outBuffer out = {ob, DCMP_BSZ, 0U};
+		size_t nrd;
+
+		if (in.pos < in.size || full) {
+			/* keep draining */
+			;
+		} else if ((nrd = dcmp_rd(d, ib, DCMP_BSZ)) > 0U) {
+			in.size = nrd;
+			in.pos = 0U;
+		} else {
+			break;
+		}
+		ret = ZSTD_decompressStream(zs, &out, &in);
+		if (ZSTD_isError(ret)) {
+			res = EIO;
+			goto out;
+		}
+		full = out.pos >= out.size;
+		if (dcmp_wr(d->fd, ob, out.pos) < 0) {
+			goto out;
+		}
+	}
+	if (ferror(d->z) || ret) {
+		/* read error or truncated */
+		res = EIO;
+	}
+out:
+	ZSTD_freeDStream(zs);
+	return res;
+}
+# endif	/* USE_ZSTD */
+
+static void*
+dcmp_thr(void *arg)
+{
+/* the decompressor thread, turn D's source into plain text */
+	struct dcmp_s *d = arg;
+	unsigned char *ib, *ob;
+	sigset_t ss;
+
+	/* we want EPIPE when the reader is gone early, not a SIGPIPE */
+	sigemptyset(&ss);
+	sigaddset(&ss, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &ss, NULL);
+
+	if (UNLIKELY((ib = malloc(DCMP_BSZ)) == NULL)) {
+		d->err = ENOMEM;
+		goto out;
+	} else if (UNLIKELY((ob = malloc(DCMP_BSZ)) == NULL)) {
+		d->err = ENOMEM;
+		free(ib);
+		goto out;
+	}
+
+	switch (d->fmt) {
+	case DCMP_NONE:
+		d->err = dcmp_cat(d, ib);
+		break;
+# if defined USE_GZIP
+	case DCMP_GZIP:
+		d->err = dcmp_gz(d, ib, ob);
+		break;
+# endif	/* USE_GZIP */
+# if defined USE_XZ
+	case DCMP_XZ:
+		d->err = dcmp_xz(d, ib, ob);
+		break;
+# endif	/* USE_XZ */
+# if defined USE_ZSTD
+	case DCMP_ZSTD:
+		d->err = dcmp_zstd(d, ib, ob);
+		break;
+# endif	/* USE_ZSTD */
+	default:
+		d->err = ENOTSUP;
+		break;
+	}
+	free(ib);
+	free(ob);
+out:
+	/* the reader sees the end of the file now */
+	close(d->fd);
+	return NULL;
+}
+
+static struct dcmp_s*
+make_dcmp(FILE *z, dcmp_fmt_t fmt, const char *pre, size_t npre)
+{
+	struct dcmp_s *d;
+	int fds[2U];
+	int err;
+
+	if (UNLIKELY((d = calloc(1, sizeof(*d))) == NULL)) {
+		return NULL;
+	} else if (UNLIKELY(pipe(fds) < 0)) {
+		goto nop;
+	} else if (UNLIKELY((d->f = fdopen(fds[0U], "r")) == NULL)) {
+		close(fds[0U]);
+		close(fds[1U]);
+		goto nop;
+	}
+#if defined F_SETPIPE_SZ
+	/* fewer round trips between us and the decompressor */
+	(void)fcntl(fds[1U], F_SETPIPE_SZ, DCMP_BSZ);
+#endif	/* F_SETPIPE_SZ */
+	(void)setvbuf(d->f, NULL, _IOFBF, DCMP_BSZ);
+	d->z = z;
+	d->fd = fds[1U];
+	d->fmt = fmt;
+	memcpy(d->pre, pre, d->npre = npre);
+	if (UNLIKELY((err = pthread_create(&d->th, NULL, dcmp_thr, d)))) {
+		fclose(d->f);
+		close(d->fd);
+		errno = err;
+		goto nop;
+	}
+	d->next = dcmps;
+	dcmps = d;
+	return d;
+
+nop:
+	free(d);
+	return NULL;
+}
+
+static int
+free_dcmp(struct dcmp_s *d)
+{
+	int err;
+
+	/* close our end first so a busy decompressor gets EPIPE */
+	fclose(d->f);
+	pthread_join(d->th, NULL);
+	fclose(d->z);
+	err = d->err;
+	free(d);
+	if (UNLIKELY(err)) {
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
+#endif	/* USE_DCMP */
+
+
+FILE*
+truf_fopen(const char *fn)
+{
+#if defined USE_DCMP
+	struct dcmp_s *d;
+#endif	/* USE_DCMP */
+	dcmp_fmt_t fmt;
+	char pre[8U];
+	size_t npre;
+	FILE *z;
+	int err;
+
+	if (fn == NULL || fn[0U] == '-' && fn[1U] == '\0') {
+		z = stdin;
+	} else if (UNLIKELY((z = fopen(fn, "r")) == NULL)) {
+		return NULL;
+	}
+
+	switch ((fmt = dcmp_fmt(z, pre, &npre))) {
+	case DCMP_NONE:
+		if (LIKELY(npre == 0U)) {
+			return z;
+		}
+		/* not compressed after all but we've read into a pipe,
+		 * a copying thread will hand those bytes back */
+		/* fallthrough */
+#if defined USE_DCMP
+# if defined USE_GZIP
+	case DCMP_GZIP:
+# endif	/* USE_GZIP */
+# if defined USE_XZ
+	case DCMP_XZ:
+# endif	/* USE_XZ */
+# if defined USE_ZSTD
+	case DCMP_ZSTD:
+# endif	/* USE_ZSTD */
+		if (LIKELY((d = make_dcmp(z, fmt, pre, npre)) != NULL)) {
+			return d->f;
+		}
+		err = errno;
+		break;
+#endif	/* USE_DCMP */
+	default:
+		/* built without support for this format */
+		err = ENOTSUP;
+		break;
+	}
+	if (z != stdin) {
+		fclose(z);
+	}
+	errno = err;
+	return NULL;
+}
+
+int
+truf_fclose(FILE *f)
+{
+#if defined USE_DCMP
+	for (struct dcmp_s **dp = &dcmps; *dp != NULL; dp = &(*dp)->next) {
+		if ((*dp)->f == f) {
+			struct dcmp_s *d = *dp;
+
+			*dp = d->next;
+			return free_dcmp(d);
+		}
+	}
+#endif	/* USE_DCMP */
+	return fclose(f);
+}
+
+/* dcmp.c ends here */
@@ -618,6 +618,100 @@ scalbndpd64(_Decimal64 x, int n)
 #endif	/* !HAVE_SCALBND64 */
 
 
+/* short decimals, less than 8 digits either side of the point, are read
+ * 8 characters at a time, words are little-endian, i.e. the first
+ * character goes into the lowest byte */
+#define SWAR_PGSZ	(4096U)
+#define SWAR_ONES	(0x0101010101010101ULL)
+
+static inline int
+swar_ld(uint64_t *restrict x, const char *s)
+{
+	/* the page after S might not be mapped */
+	if (UNLIKELY(((uintptr_t)s & (SWAR_PGSZ - 1U)) > SWAR_PGSZ - 8U)) {
+		return -1;
+	}
+	memcpy(x, s, sizeof(*x));
+#if defined WORDS_BIGENDIAN
+	*x = __builtin_bswap64(*x);
+#endif	/* WORDS_BIGENDIAN */
+	return 0;
+}
+
+static inline __attribute__((const)) unsigned int
+swar_ndigs(uint64_t x)
+{
+/* return the number of leading digits in X */
+	const uint64_t hi = 0xf0U * SWAR_ONES;
+	const uint64_t zz = 0x30U * SWAR_ONES;
+	uint64_t t = ((x & hi) ^ zz) | (((x + 0x06U * SWAR_ONES) & hi) ^ zz);
+
+	return t ? (unsigned int)__builtin_ctzll(t) / 8U : 8U;
+}
+
+static inline __attribute__((const)) uint64_t
+swar_digs(uint64_t x, unsigned int n)
+{
+/* return the value of the first N digits of X */
+	if (UNLIKELY(!n)) {
+		return 0U;
+	}
+	/* move digits to the top, zeroes come in as leading naughts */
+	x = (x ^ 0x30U * SWAR_ONES) << ((8U - n) * 8U);
+	x = (x * 10U) + (x >> 8U);
+	x = ((x & 0x000000ff000000ffULL) * (100U + (1000000ULL << 32U)) +
+	     ((x >> 16U) & 0x000000ff000000ffULL) * (1U + (10000ULL << 32U)));
+	return x >> 32U;
+}
+
+static int
+strtosd64(uint64_t *restrict m, int *restrict e, int *restrict s,
+	  const char *src, char **on)
+{
+/* read a short decimal off SRC into a binary mantissa M, exponent E
+ * and sign S, return -1 if the decimal isn't short */
+	static const uint64_t p10[] = {
+		1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U, 10000000U,
+	};
+	const char *sp = src;
+	unsigned int ni, nf;
+	uint64_t x;
+
+	*s = 0;
+	if (UNLIKELY(*sp == '-')) {
+		*s = 1;
+		sp++;
+	} else if (UNLIKELY(*sp == '+')) {
+		sp++;
+	}
+	/* skip leading zeros like the bcd reader */
+	for (; *sp == '0'; sp++);
+
+	if (UNLIKELY(swar_ld(&x, sp) < 0)) {
+		return -1;
+	} else if (UNLIKELY((ni = swar_ndigs(x)) >= 8U)) {
+		return -1;
+	}
+	*m = swar_digs(x, ni);
+	*e = 0;
+	sp += ni;
+	if (*sp++ != '.') {
+		sp--;
+	} else if (UNLIKELY(swar_ld(&x, sp) < 0)) {
+		return -1;
+	} else if (UNLIKELY((nf = swar_ndigs(x)) >= 8U)) {
+		return -1;
+	} else {
+		*m = *m * p10[nf] + swar_digs(x, nf);
+		*e = -(int)nf;
+		sp += nf;
+	}
+	if (LIKELY(on != NULL)) {
+		*on = deconst(sp);
+	}
+	return 0;
+}
+
 #if defined HAVE_DFP754_BID_LITERALS
 static _Decimal64
 strtobid64(const char *src, char **on)
@@ -625,7 +719,16 @@ strtobid64(const char *src, char **on)
 /* d64s look like s??eeeeee mm..23..mm
  * and the decimal is (-1 * s) * m * 10^(e - 101),
  * this implementation is very minimal serving only the cattle use cases */
-	bcd64_t b = strtobcd64(src, on);
+	uint64_t m;
+	int e, s;
+	bcd64_t b;
+
+	if (LIKELY(!strtosd64(&m, &e, &s, src, on))) {
+		/* mantissa is binary already */
+		return assemble_bid(m, e + 398, s);
+	}
+	/* no luck, go through bcd */
+	b = strtobcd64(src, on);
 	return bcd64tobid(b);
 }
 #elif defined HAVE_DFP754_DPD_LITERALS
@@ -635,7 +738,21 @@ strtodpd64(const char *src, char **on)
 /* d64s look like s??eeeeee mm..23..mm
  * and the decimal is (-1 * s) * m * 10^(e - 101),
  * this implementation is very minimal serving only the cattle use cases */
-	bcd64_t b = strtobcd64(src, on);
+	uint64_t m;
+	int e, s;
+	bcd64_t b;
+
+	if (LIKELY(!strtosd64(&m, &e, &s, src, on))) {
+		/* mantissa has less than 15 digits, bcd it */
+		uint_least64_t bcdm = 0U;
+
+		for (unsigned int sh = 0U; m; sh += 4U, m /= 10U) {
+			bcdm ^= (m % 10U) << sh;
+		}
+		return bcd64todpd((bcd64_t){bcdm, e, s});
+	}
+	/* no luck, go through bcd */
+	b = strtobcd64(src, on);
 	return bcd64todpd(b);
 }
 #endif	/* HAVE_DFP754_BID_LITERALS || HAVE_DFP754_DPD_LITERALS */
@@ -654,6 +771,59 @@ strtod64(const char *src, char **on)
 
 
 #if defined HAVE_DFP754_BID_LITERALS
+/* two-digit decimals for the fast formatter */
+static const char dig2[200U] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+static size_t
+bin64tostr(char *restrict buf, size_t bsz, uint_least64_t m, int e, int s)
+{
+/* fast path for binary mantissas M < 10^16 and exponents -16 <= E <= 0,
+ * digits are produced in pairs back to front, then copied in one go,
+ * returns 0 if BUF is too small */
+	char tmp[20U];
+	char *const te = tmp + sizeof(tmp);
+	char *tp = te;
+	char *bp = buf;
+	size_t ni;
+
+	for (; m >= 100U; m /= 100U) {
+		tp -= 2U;
+		memcpy(tp, dig2 + 2U * (m % 100U), 2U);
+	}
+	if (m >= 10U) {
+		tp -= 2U;
+		memcpy(tp, dig2 + 2U * m, 2U);
+	} else {
+		*--tp = C(m);
+	}
+	/* zero-pad so there's at least one digit left of the point */
+	while (te - tp <= -e) {
+		*--tp = '0';
+	}
+	/* number of integral digits */
+	ni = (te - tp) + e;
+	if (UNLIKELY(bsz < (size_t)(te - tp) + 3U)) {
+		return 0U;
+	}
+	if (s) {
+		*bp++ = '-';
+	}
+	memcpy(bp, tp, ni);
+	bp += ni;
+	if (e < 0) {
+		*bp++ = '.';
+		memcpy(bp, tp + ni, -e);
+		bp -= e;
+	}
+	*bp = '\0';
+	return bp - buf;
+}
+
 static int
 bid64tostr(char *restrict buf, size_t bsz, _Decimal64 x)
 {
@@ -669,6 +839,15 @@ bid64tostr(char *restrict buf, size_t bsz, _Decimal64 x)
 	m = mant_bid64(x);
 	s = m ? sign_bid64(x) : 0/*no stinking signed naughts*/;
 
+	if (LIKELY(m < 10000000000000000ULL && e <= 0 && e >= -16)) {
+		/* the common case, prices and sizes */
+		size_t z;
+
+		if (LIKELY((z = bin64tostr(buf, bsz, m, e, s)) > 0U)) {
+			return (int)z;
+		}
+	}
+
 	/* reencode m as bcd */
 	with (uint_least64_t bcdm = 0U) {
 		for (size_t i = 0; i < 16U; i++) {
@@ -42,6 +42,7 @@
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
 #include <stdint.h>
+#include <string.h>
 #include "dt-strpf.h"
 #include "nifty.h"
 
@@ -108,6 +109,160 @@ ui32tostr(char *restrict buf, size_t bsz, uint32_t d, int pad)
 	return res;
 }
 
+/* SWAR helpers for fixed-width stamps, words are little-endian,
+ * i.e. the first character of a string goes into the lowest byte */
+#define SWAR_PGSZ	(4096U)
+#define SWAR_ONES	(0x0101010101010101ULL)
+
+static inline uint64_t
+swar_ld(const char *s)
+{
+	uint64_t x;
+	memcpy(&x, s, sizeof(x));
+#if defined WORDS_BIGENDIAN
+	x = __builtin_bswap64(x);
+#endif	/* WORDS_BIGENDIAN */
+	return x;
+}
+
+static inline __attribute__((const)) int
+swar_digs_p(uint64_t x, uint64_t m)
+{
+/* check that all bytes of X selected by mask M are in '0'..'9' */
+	const uint64_t hi = 0xf0U * SWAR_ONES & m;
+	const uint64_t zz = 0x30U * SWAR_ONES & m;
+	return (x & hi) == zz && ((x + 0x06U * SWAR_ONES) & hi) == zz;
+}
+
+static inline __attribute__((const)) uint64_t
+swar_pairs(uint64_t x, uint64_t m)
+{
+/* turn digits selected by M into 2-digit numbers, byte I of the result
+ * holds the number made up of digits I and I+1 */
+	x = (x ^ 0x30U * SWAR_ONES) & m;
+	return x * 10U + (x >> 8U);
+}
+
+static inline __attribute__((const)) unsigned int
+swar_byte(uint64_t x, unsigned int i)
+{
+	return (x >> (i * 8U)) & 0xffU;
+}
+
+static const char*
+strp_swar_time(echs_instant_t *restrict res, const char *str)
+{
+/* parse HH:MM:SS in one go, return a pointer past the time or NULL
+ * if the time is unusual, reads up to 9 bytes off of STR */
+	static const uint64_t dm = 0xffff00ffff00ffffULL;
+	static const uint64_t sm = 0x0000ff0000ff0000ULL;
+	static const uint64_t sv = 0x00003a00003a0000ULL;
+	unsigned int H, M, S;
+	uint64_t w, p;
+
+	w = swar_ld(str);
+	if ((w & sm) != sv || !swar_digs_p(w, dm) ||
+	    /* leave milliseconds to the generic parser */
+	    str[8U] == '.') {
+		return NULL;
+	}
+	p = swar_pairs(w, dm);
+	H = swar_byte(p, 0U);
+	M = swar_byte(p, 3U);
+	S = swar_byte(p, 6U);
+	if (UNLIKELY(H > 23U || M > 59U || S > 60U)) {
+		return NULL;
+	}
+	res->H = H, res->M = M, res->S = S;
+	res->ms = ECHS_ALL_SEC;
+	return str + 8U;
+}
+
+static const char*
+strp_swar(echs_instant_t *restrict res, const char *str)
+{
+/* parse YYYY-MM-DD and YYYY-MM-DD[T ]HH:MM:SS in one go,
+ * return a pointer past the stamp or NULL if the stamp is unusual */
+	/* digit mask, separator mask and separator values */
+	static const uint64_t dm = 0x00ffff00ffffffffULL;
+	static const uint64_t sm = 0xff0000ff00000000ULL;
+	static const uint64_t sv = 0x2d00002d00000000ULL;
+	unsigned int y, m, d;
+	uint64_t w, p;
+
+	/* we read up to 20 bytes off of STR, the page after might
+	 * not be mapped so don't cross any page boundaries */
+	if (UNLIKELY(((uintptr_t)str & (SWAR_PGSZ - 1U)) > SWAR_PGSZ - 20U)) {
+		return NULL;
+	}
+	w = swar_ld(str);
+	if ((w & sm) != sv || !swar_digs_p(w, dm)) {
+		return NULL;
+	}
+	p = swar_pairs(w, dm);
+	y = swar_byte(p, 0U) * 100U + swar_byte(p, 2U);
+	m = swar_byte(p, 5U);
+
+	w = swar_ld(str + 8U);
+	if (!swar_digs_p(w, 0xffffU)) {
+		return NULL;
+	}
+	p = swar_pairs(w, 0xffffU);
+	d = swar_byte(p, 0U);
+	/* ranges as in the generic parser */
+	if (UNLIKELY(y < 1583U || y > 4095U || m > 12U || d > 31U)) {
+		return NULL;
+	}
+	res->y = y, res->m = m, res->d = d;
+
+	switch (str[10U]) {
+	case ' ':
+	case 'T':
+		break;
+	default:
+		/* just the date */
+		res->H = ECHS_ALL_DAY;
+		return str + 10U;
+	}
+	return strp_swar_time(res, str + 11U);
+}
+
+static const char*
+strp_time(echs_instant_t *restrict res, const char *sp)
+{
+/* parse the time part of a stamp the generic way,
+ * return a pointer past the time or NULL if it's no time */
+	int32_t tmp;
+
+	if ((tmp = strtoi_lim(sp, &sp, 0, 23)) < 0 || *sp++ != ':') {
+		return NULL;
+	}
+	res->H = tmp;
+
+	/* minute */
+	if ((tmp = strtoi_lim(sp, &sp, 0, 59)) < 0 || *sp++ != ':') {
+		return NULL;
+	}
+	res->M = tmp;
+
+	/* second, allow leap second too */
+	if ((tmp = strtoi_lim(sp, &sp, 0, 60)) < 0) {
+		return NULL;
+	}
+	res->S = tmp;
+
+	/* millisecond part */
+	if (*sp++ != '.') {
+		/* make it ALL_SEC then */
+		tmp = ECHS_ALL_SEC;
+		sp--;
+	} else if ((tmp = strtoi_lim(sp, &sp, 0, 999)) < 0) {
+		return NULL;
+	}
+	res->ms = tmp;
+	return sp;
+}
+
 
 echs_instant_t
 dt_strp(const char *str, char **on)
@@ -116,12 +271,20 @@ dt_strp(const char *str, char **on)
 	static echs_instant_t nul;
 	echs_instant_t res = {};
 	const char *sp;
+	const char *tp;
 	int32_t tmp;
 
 	if (UNLIKELY((sp = str) == NULL)) {
 		res = nul;
 		goto nul;
+	} else if (LIKELY((tp = strp_swar(&res, str)) != NULL)) {
+		/* fixed-width stamp */
+		sp = tp;
+		goto nul;
 	}
+	/* the slow way then */
+	res = nul;
+
 	/* read the year */
 	if ((tmp = strtoi_lim(sp, &sp, 1583, 4095)) < 0 || *sp++ != '-') {
 		res = nul;
@@ -159,49 +322,100 @@ dt_strp(const char *str, char **on)
 	}
 
 	/* and now parse the time */
-	if ((tmp = strtoi_lim(sp, &sp, 0, 23)) < 0 || *sp++ != ':') {
+	if ((tp = strp_time(&res, sp)) == NULL) {
 		res = nul;
 		goto nul;
 	}
-	res.H = tmp;
-
-	/* minute */
-	if ((tmp = strtoi_lim(sp, &sp, 0, 59)) < 0 || *sp++ != ':') {
-		res = nul;
-		goto nul;
+	sp = tp;
+nul:
+	if (LIKELY(on != NULL)) {
+		*on = deconst(sp);
 	}
-	res.M = tmp;
+	return res;
+}
 
-	/* second, allow leap second too */
-	if ((tmp = strtoi_lim(sp, &sp, 0, 60)) < 0) {
-		res = nul;
-		goto nul;
-	}
-	res.S = tmp;
+echs_instant_t
+dt_strp_time(echs_instant_t d, const char *str, char **on)
+{
+	static echs_instant_t nul;
+	echs_instant_t res = {.dpart = d.dpart};
+	const char *sp = str;
+	const char *tp;
 
-	/* millisecond part */
-	if (*sp++ != '.') {
-		/* make it ALL_SEC then */
-		tmp = ECHS_ALL_SEC;
-		sp--;
-	} else if ((tmp = strtoi_lim(sp, &sp, 0, 999)) < 0) {
+	if (LIKELY(((uintptr_t)str & (SWAR_PGSZ - 1U)) <= SWAR_PGSZ - 9U) &&
+	    LIKELY((tp = strp_swar_time(&res, str)) != NULL)) {
+		/* fixed-width time */
+		sp = tp;
+	} else if ((tp = strp_time(&res, str)) != NULL) {
+		sp = tp;
+	} else {
 		res = nul;
-		goto nul;
 	}
-	res.ms = tmp;
-nul:
 	if (LIKELY(on != NULL)) {
 		*on = deconst(sp);
 	}
 	return res;
 }
 
+static const char dig2[200U] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
 size_t
 dt_strf(char *restrict buf, size_t bsz, echs_instant_t inst)
 {
+/* consecutive stamps tend to share the date, so keep the last rendered
+ * YYYY-MM-DD around and only do the intraday fields, using a table of
+ * two-digit strings */
+	static uint32_t cdpart;
+	static char cdate[10U] = "0000-00-00";
 	char *restrict bp = buf;
 #define bz	(bsz - (bp - buf))
 
+	if (UNLIKELY(bsz < sizeof("YYYY-MM-DDTHH:MM:SS.xxx"))) {
+		goto slow;
+	} else if (UNLIKELY(inst.dpart != cdpart)) {
+		(void)ui32tostr(cdate + 0U, 4U, inst.y, 4);
+		cdate[4U] = '-';
+		(void)ui32tostr(cdate + 5U, 2U, inst.m, 2);
+		cdate[7U] = '-';
+		(void)ui32tostr(cdate + 8U, 2U, inst.d, 2);
+		cdpart = inst.dpart;
+	}
+	memcpy(bp, cdate, sizeof(cdate));
+	bp += sizeof(cdate);
+
+	if (echs_instant_all_day_p(inst)) {
+		/* date only */
+		;
+	} else if (UNLIKELY(inst.H >= 100U || inst.M >= 100U)) {
+		/* beyond our table */
+		goto slow;
+	} else {
+		*bp++ = 'T';
+		memcpy(bp, dig2 + 2U * inst.H, 2U);
+		bp += 2U;
+		*bp++ = ':';
+		memcpy(bp, dig2 + 2U * inst.M, 2U);
+		bp += 2U;
+		*bp++ = ':';
+		memcpy(bp, dig2 + 2U * inst.S, 2U);
+		bp += 2U;
+		if (LIKELY(!echs_instant_all_sec_p(inst))) {
+			*bp++ = '.';
+			*bp++ = (char)(inst.ms / 100U % 10U + '0');
+			memcpy(bp, dig2 + 2U * (inst.ms % 100U), 2U);
+			bp += 2U;
+		}
+	}
+	*bp = '\0';
+	return bp - buf;
+
+slow:
+	bp = buf;
 	bp += ui32tostr(bp, bz, inst.y, 4);
 	*bp++ = '-';
 	bp += ui32tostr(bp, bz, inst.m, 2);
@@ -256,6 +470,10 @@ echs_idiff_rd(const char *str, char **on)
 		res.dd = tmp / (24 * 60);
 		res.msd = (tmp % (24 * 60)) * 60 * 1000;
 		break;
+	case '\0':
+		/* no suffix means seconds */
+		sp--;
+		/* fallthrough */
 	case 's':
 	case 'S':
 		res.dd = tmp / (24 * 60 * 60);
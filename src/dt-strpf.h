@@ -44,6 +44,12 @@
  * Parse STR with the standard parser. */
 extern echs_instant_t dt_strp(const char *str, char **on);
 
+/**
+ * Parse the time part STR of a stamp (the bit after the date/time
+ * separator) and return it along with the date part of D. */
+extern echs_instant_t
+dt_strp_time(echs_instant_t d, const char *str, char **on);
+
 /**
  * Print INST into BUF (of size BSZ) and return its length. */
 extern size_t dt_strf(char *restrict buf, size_t bsz, echs_instant_t inst);
@@ -0,0 +1,117 @@
+/*** idx.c -- sparse time indices for tser files
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "idx.h"
+#include "rdr.h"
+#include "dt-strpf.h"
+#include "nifty.h"
+
+
+int
+truf_idx_wr(FILE *idx, FILE *f)
+{
+	truf_rdr_t r;
+	const char *line;
+	ssize_t nrd;
+	/* offset of the current line */
+	off_t o;
+	/* date part of the last entry and lines since then */
+	uint32_t odp = 0U;
+	size_t nln = 0U;
+
+	if ((o = ftello(f)) < 0) {
+		o = 0;
+	}
+	if (UNLIKELY((r = make_truf_rdr(f)) == NULL)) {
+		return -1;
+	}
+	for (; (nrd = truf_rdr_line(r, &line)) > 0; o += nrd) {
+		echs_instant_t t;
+		char buf[64U];
+		size_t z;
+
+		if (*line == '#') {
+			continue;
+		} else if (echs_instant_0_p(t = dt_strp(line, NULL))) {
+			continue;
+		} else if (t.dpart == odp && ++nln < TRUF_IDX_NLN) {
+			continue;
+		}
+		/* new day or enough lines, make an entry */
+		z = dt_strf(buf, sizeof(buf), t);
+		buf[z++] = '\t';
+		z += snprintf(buf + z, sizeof(buf) - z, "%lld\n", (long long)o);
+		fwrite(buf, 1U, z, idx);
+		odp = t.dpart;
+		nln = 0U;
+	}
+	if (UNLIKELY(free_truf_rdr(r) < 0)) {
+		return -1;
+	}
+	return ferror(idx) ? -1 : 0;
+}
+
+off_t
+truf_idx_find(FILE *idx, echs_instant_t from)
+{
+	char *line = NULL;
+	size_t llen = 0UL;
+	off_t res = 0;
+
+	while (getline(&line, &llen, idx) > 0) {
+		echs_instant_t t;
+		char *on;
+
+		if (echs_instant_0_p(t = dt_strp(line, &on)) || *on != '\t') {
+			continue;
+		} else if (!echs_instant_lt_p(t, from)) {
+			/* entries are ordered */
+			break;
+		}
+		res = strtoll(on + 1U, NULL, 10);
+	}
+	free(line);
+	return res;
+}
+
+/* idx.c ends here */
@@ -0,0 +1,63 @@
+/*** idx.h -- sparse time indices for tser files
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_idx_h_
+#define INCLUDED_idx_h_
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "instant.h"
+
+/**
+ * Indices are text files with STAMP<TAB>OFFSET lines, one for the first
+ * line of every day in the tser file and one for every TRUF_IDX_NLN-th
+ * line within a day, OFFSET being the byte offset of that line.
+ * Indices only make sense for chronologically ordered tser files. */
+#define TRUF_IDX_NLN	(65536U)
+
+
+/**
+ * Write an index of the tser file F, read from its current position,
+ * to IDX. */
+extern int truf_idx_wr(FILE *idx, FILE *f);
+
+/**
+ * Return the offset of the last line in index IDX stamped before FROM.
+ * All lines before that offset are stamped before FROM as well.
+ * Return 0 if there's no such line. */
+extern off_t truf_idx_find(FILE *idx, echs_instant_t from);
+
+#endif	/* INCLUDED_idx_h_ */
@@ -160,6 +160,10 @@ echs_instant_diff(echs_instant_t end, echs_instant_t beg)
 		intra_df += 24 * 60 * 60 * 1000;
 		extra_df = -1;
 	} else if (intra_df < 24 * 60 * 60 * 1000) {
+		if (end.dpart == beg.dpart) {
+			/* same day, no need to count days */
+			return (echs_idiff_t){0, intra_df};
+		}
 		extra_df = 0;
 	} else {
 		extra_df = 1;
@@ -43,8 +43,12 @@
 typedef union echs_instant_u echs_instant_t;
 typedef struct echs_idiff_s echs_idiff_t;
 
+/* fields are laid out so that U orders like the instant itself,
+ * i.e. year in the most significant bits, regardless of byte order,
+ * which makes comparisons single integer comparisons */
 union echs_instant_u {
 	struct {
+#if defined WORDS_BIGENDIAN
 		uint32_t y:16;
 		uint32_t m:8;
 		uint32_t d:8;
@@ -52,10 +56,24 @@ union echs_instant_u {
 		uint32_t M:8;
 		uint32_t S:6;
 		uint32_t ms:10;
+#else  /* !WORDS_BIGENDIAN */
+		uint32_t ms:10;
+		uint32_t S:6;
+		uint32_t M:8;
+		uint32_t H:8;
+		uint32_t d:8;
+		uint32_t m:8;
+		uint32_t y:16;
+#endif	/* WORDS_BIGENDIAN */
 	};
 	struct {
+#if defined WORDS_BIGENDIAN
 		uint32_t dpart;
 		uint32_t intra;
+#else  /* !WORDS_BIGENDIAN */
+		uint32_t intra;
+		uint32_t dpart;
+#endif	/* WORDS_BIGENDIAN */
 	};
 	uint64_t u;
 } __attribute__((transparent_union));
@@ -95,40 +113,30 @@ echs_instant_0_p(echs_instant_t x)
 	return x.u == 0U;
 }
 
+static inline __attribute__((pure, const)) uint64_t
+echs_instant_key(echs_instant_t x)
+{
+/* return an integer that orders like X */
+	return x.u;
+}
+
 static inline __attribute__((pure, const)) bool
 echs_instant_lt_p(echs_instant_t x, echs_instant_t y)
 {
-#if defined WORDS_BIGENDIAN
 	return x.u < y.u;
-#else  /* !WORDS_BIGENDIAN */
-	/* the bitfield is in big-endian order and we're on little-E
-	 * so we have to go through it slot by slot */
-	return (x.y < y.y || x.y == y.y &&
-		(x.m < y.m || x.m == y.m &&
-		 (x.d < y.d || x.d == y.d &&
-		  (x.H < y.H || x.H == y.H &&
-		   (x.M < y.M || x.M == y.M &&
-		    (x.S < y.S || x.S == y.S &&
-		     (x.ms < y.ms)))))));
-#endif	/* WORDS_BIGENDIAN */
+}
+
+static inline __attribute__((pure, const)) bool
+echs_instant_intra_lt_p(echs_instant_t x, echs_instant_t y)
+{
+/* like echs_instant_lt_p() for instants X and Y of the same day */
+	return x.intra < y.intra;
 }
 
 static inline __attribute__((pure, const)) bool
 echs_instant_le_p(echs_instant_t x, echs_instant_t y)
 {
-#if defined WORDS_BIGENDIAN
-	return !(x.u > y.u);
-#else  /* !WORDS_BIGENDIAN */
-	/* the bitfield is in big-endian order and we're on little-E
-	 * so we have to go through it slot by slot */
-	return !(x.y > y.y || x.y == y.y &&
-		 (x.m > y.m || x.m == y.m &&
-		  (x.d > y.d || x.d == y.d &&
-		   (x.H > y.H || x.H == y.H &&
-		    (x.M > y.M || x.M == y.M &&
-		     (x.S > y.S || x.S == y.S &&
-		      (x.ms > y.ms)))))));
-#endif	/* WORDS_BIGENDIAN */
+	return x.u <= y.u;
 }
 
 static inline __attribute__((pure, const)) bool
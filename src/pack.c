@@ -0,0 +1,384 @@
+/*** pack.c -- binary columnar quote series
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "pack.h"
+#include "nifty.h"
+
+#define PACK_VERSION	(2U)
+#define PACK_BOM	(0x01020304U)
+#if defined HAVE_DFP754_BID_LITERALS
+# define PACK_ENC	((uint32_t)'b')
+#elif defined HAVE_DFP754_DPD_LITERALS
+# define PACK_ENC	((uint32_t)'d')
+#endif	/* HAVE_DFP754_*_LITERALS */
+
+struct pack_hdr_s {
+	char magic[7U];
+	uint8_t version;
+	/* byte order mark */
+	uint32_t bom;
+	/* decimal encoding */
+	uint32_t enc;
+};
+
+struct pack_blk_s {
+	/* number of rows in this block */
+	uint32_t nrow;
+	/* number of new symbols in this block */
+	uint32_t nsym;
+};
+
+struct pack_sym_s {
+	/* the mmy itself, or 0 if a string of length LEN follows */
+	uint32_t mmy;
+	uint32_t len;
+};
+
+struct truf_pack_s {
+	FILE *f;
+	bool wrp;
+
+	/* current block, I is the read index in read mode */
+	size_t n;
+	size_t i;
+	uint64_t t[TRUF_PACK_NROW];
+	uint32_t s[TRUF_PACK_NROW];
+	truf_price_t bid[TRUF_PACK_NROW];
+	truf_price_t ask[TRUF_PACK_NROW];
+	truf_quant_t vol[TRUF_PACK_NROW];
+	truf_quant_t opi[TRUF_PACK_NROW];
+
+	/* symbol dictionary, index 0 is the empty symbol */
+	truf_sym_t *syms;
+	size_t nsyms;
+	size_t zsyms;
+	/* number of symbols already written (write mode) */
+	size_t osyms;
+	/* symbol to index map (write mode), 2-power sized */
+	struct {
+		truf_sym_t sym;
+		uint32_t idx;
+	} *map;
+	size_t zmap;
+};
+
+static const char magic[7U] = "\x7ftrufpk";
+
+
+static inline size_t
+get_off(size_t idx, size_t mod)
+{
+	/* no need to negate MOD as it's a 2-power */
+	return -idx % mod;
+}
+
+static uint32_t
+add_sym(truf_pack_t p, truf_sym_t sym)
+{
+	if (UNLIKELY(p->nsyms >= p->zsyms)) {
+		p->zsyms = p->zsyms ? 2U * p->zsyms : 64U;
+		p->syms = realloc(p->syms, p->zsyms * sizeof(*p->syms));
+	}
+	p->syms[p->nsyms] = sym;
+	return (uint32_t)p->nsyms++;
+}
+
+static void
+rehash(truf_pack_t p)
+{
+	const size_t nuz = p->zmap ? 2U * p->zmap : 64U;
+
+	free(p->map);
+	p->map = calloc(nuz, sizeof(*p->map));
+	p->zmap = nuz;
+	/* reinsert all but the empty symbol */
+	for (size_t i = 1U; i < p->nsyms; i++) {
+		size_t off = get_off(truf_sym_hx(p->syms[i]), nuz);
+
+		for (; p->map[off].sym.u; off = (off + 1U) % nuz);
+		p->map[off].sym = p->syms[i];
+		p->map[off].idx = (uint32_t)i;
+	}
+	return;
+}
+
+static uint32_t
+find_sym(truf_pack_t p, truf_sym_t sym)
+{
+	size_t off;
+
+	if (UNLIKELY(!sym.u)) {
+		return 0U;
+	} else if (UNLIKELY(2U * p->nsyms >= p->zmap)) {
+		/* keep the load factor below 1/2 */
+		rehash(p);
+	}
+	for (off = get_off(truf_sym_hx(sym), p->zmap);
+	     p->map[off].sym.u; off = (off + 1U) % p->zmap) {
+		if (p->map[off].sym.u == sym.u) {
+			return p->map[off].idx;
+		}
+	}
+	/* new symbol then */
+	p->map[off].sym = sym;
+	return p->map[off].idx = add_sym(p, sym);
+}
+
+static int
+wr_blk(truf_pack_t p)
+{
+	struct pack_blk_s b = {
+		.nrow = (uint32_t)p->n,
+		.nsym = (uint32_t)(p->nsyms - p->osyms),
+	};
+
+	if (UNLIKELY(fwrite(&b, sizeof(b), 1U, p->f) < 1U)) {
+		return -1;
+	}
+	/* new dictionary entries */
+	for (; p->osyms < p->nsyms; p->osyms++) {
+		truf_sym_t sym = p->syms[p->osyms];
+		struct pack_sym_s ps = {0U};
+		char buf[256U];
+
+		if (truf_mmy_p(sym)) {
+			ps.mmy = (uint32_t)sym.u;
+		} else {
+			ps.len = (uint32_t)truf_sym_wr(buf, sizeof(buf), sym);
+		}
+		fwrite(&ps, sizeof(ps), 1U, p->f);
+		fwrite(buf, sizeof(*buf), ps.len, p->f);
+	}
+	/* the columns */
+	fwrite(p->t, sizeof(*p->t), p->n, p->f);
+	fwrite(p->s, sizeof(*p->s), p->n, p->f);
+	fwrite(p->bid, sizeof(*p->bid), p->n, p->f);
+	fwrite(p->ask, sizeof(*p->ask), p->n, p->f);
+	fwrite(p->vol, sizeof(*p->vol), p->n, p->f);
+	fwrite(p->opi, sizeof(*p->opi), p->n, p->f);
+	p->n = 0U;
+	return ferror(p->f) ? -1 : 0;
+}
+
+static int
+rd_blk(truf_pack_t p)
+{
+	struct pack_blk_s b;
+
+	p->n = p->i = 0U;
+	if (UNLIKELY(fread(&b, sizeof(b), 1U, p->f) < 1U)) {
+		return -1;
+	} else if (UNLIKELY(b.nrow > TRUF_PACK_NROW)) {
+		return -1;
+	}
+	/* new dictionary entries */
+	for (size_t i = 0U; i < b.nsym; i++) {
+		struct pack_sym_s ps;
+		char buf[256U];
+		truf_sym_t sym;
+
+		if (UNLIKELY(fread(&ps, sizeof(ps), 1U, p->f) < 1U)) {
+			return -1;
+		} else if (UNLIKELY(ps.len >= sizeof(buf))) {
+			return -1;
+		} else if (!ps.len) {
+			sym.u = ps.mmy;
+		} else if (fread(buf, sizeof(*buf), ps.len, p->f) < ps.len) {
+			return -1;
+		} else {
+			buf[ps.len] = '\0';
+			sym = truf_sym_rd(buf, NULL);
+		}
+		add_sym(p, sym);
+	}
+	/* the columns */
+	if (fread(p->t, sizeof(*p->t), b.nrow, p->f) < b.nrow ||
+	    fread(p->s, sizeof(*p->s), b.nrow, p->f) < b.nrow ||
+	    fread(p->bid, sizeof(*p->bid), b.nrow, p->f) < b.nrow ||
+	    fread(p->ask, sizeof(*p->ask), b.nrow, p->f) < b.nrow ||
+	    fread(p->vol, sizeof(*p->vol), b.nrow, p->f) < b.nrow ||
+	    fread(p->opi, sizeof(*p->opi), b.nrow, p->f) < b.nrow) {
+		return -1;
+	}
+	/* check symbol indices */
+	for (size_t i = 0U; i < b.nrow; i++) {
+		if (UNLIKELY(p->s[i] >= p->nsyms)) {
+			return -1;
+		}
+	}
+	p->n = b.nrow;
+	return 0;
+}
+
+
+bool
+truf_pack_p(FILE *f)
+{
+	int c = getc(f);
+
+	if (UNLIKELY(c == EOF)) {
+		return false;
+	}
+	ungetc(c, f);
+	return c == *magic;
+}
+
+truf_pack_t
+make_truf_pack_wr(FILE *f)
+{
+	static const struct pack_hdr_s hdr = {
+		.version = PACK_VERSION,
+		.bom = PACK_BOM,
+		.enc = PACK_ENC,
+	};
+	truf_pack_t p;
+
+	if (UNLIKELY((p = calloc(1, sizeof(*p))) == NULL)) {
+		return NULL;
+	}
+	p->f = f;
+	/* the empty symbol */
+	add_sym(p, (truf_sym_t){0U});
+	p->osyms = 1U;
+
+	with (struct pack_hdr_s h = hdr) {
+		memcpy(h.magic, magic, sizeof(magic));
+		if (UNLIKELY(fwrite(&h, sizeof(h), 1U, f) < 1U)) {
+			free_truf_pack(p);
+			return NULL;
+		}
+	}
+	p->wrp = true;
+	return p;
+}
+
+truf_pack_t
+make_truf_pack_rd(FILE *f)
+{
+	struct pack_hdr_s h;
+	truf_pack_t p;
+
+	if (UNLIKELY(fread(&h, sizeof(h), 1U, f) < 1U)) {
+		return NULL;
+	} else if (memcmp(h.magic, magic, sizeof(magic))) {
+		return NULL;
+	} else if (h.version != PACK_VERSION ||
+		   h.bom != PACK_BOM || h.enc != PACK_ENC) {
+		/* could be byte-swapped but we don't do that */
+		return NULL;
+	} else if (UNLIKELY((p = calloc(1, sizeof(*p))) == NULL)) {
+		return NULL;
+	}
+	p->f = f;
+	p->wrp = false;
+	/* the empty symbol */
+	add_sym(p, (truf_sym_t){0U});
+	return p;
+}
+
+int
+free_truf_pack(truf_pack_t p)
+{
+	int rc = 0;
+
+	if (p->wrp) {
+		/* flush the last block and terminate the file */
+		if (p->n) {
+			rc = wr_blk(p);
+		}
+		rc |= wr_blk(p);
+	}
+	if (p->syms != NULL) {
+		free(p->syms);
+	}
+	if (p->map != NULL) {
+		free(p->map);
+	}
+	free(p);
+	return rc;
+}
+
+int
+truf_pack_add(truf_pack_t p, const struct truf_step_s *st)
+{
+	const size_t i = p->n++;
+
+	p->t[i] = st->t.u;
+	p->s[i] = find_sym(p, st->sym);
+	p->bid[i] = st->bid;
+	p->ask[i] = st->ask;
+	p->vol[i] = st->vol;
+	p->opi[i] = st->opi;
+	if (UNLIKELY(p->n >= TRUF_PACK_NROW)) {
+		return wr_blk(p);
+	}
+	return 0;
+}
+
+int
+truf_pack_next(truf_pack_t p, struct truf_step_s *st)
+{
+	size_t i;
+
+	if (UNLIKELY((i = p->i) >= p->n)) {
+		/* get a new block */
+		if (UNLIKELY(rd_blk(p) < 0)) {
+			return -2;
+		} else if (!p->n) {
+			/* terminating block */
+			return -1;
+		}
+		i = 0U;
+	}
+	st->t.u = p->t[i];
+	st->sym = p->syms[p->s[i]];
+	st->bid = p->bid[i];
+	st->ask = p->ask[i];
+	st->vol = p->vol[i];
+	st->opi = p->opi[i];
+	p->i = i + 1U;
+	return 0;
+}
+
+/* pack.c ends here */
@@ -0,0 +1,84 @@
+/*** pack.h -- binary columnar quote series
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_pack_h_
+#define INCLUDED_pack_h_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "step.h"
+
+/**
+ * Packed tser files consist of a header followed by blocks of at most
+ * TRUF_PACK_NROW decoded quote lines.  Each block starts with its
+ * number of rows and the symbols that first appear in it, followed by
+ * the columns (instants, symbol indices, bids, asks, volumes, open
+ * interests) as raw arrays.  A block with 0 rows terminates the file.
+ *
+ * Byte order and decimal encoding are those of the writing host. */
+typedef struct truf_pack_s *truf_pack_t;
+
+#define TRUF_PACK_NROW	(16384U)
+
+
+/**
+ * Return true if F looks like a packed tser file, nothing is consumed. */
+extern bool truf_pack_p(FILE *f);
+
+/**
+ * Prepare to write a packed tser file to F. */
+extern truf_pack_t make_truf_pack_wr(FILE *f);
+
+/**
+ * Prepare to read a packed tser file from F.
+ * Return NULL if the header is not understood. */
+extern truf_pack_t make_truf_pack_rd(FILE *f);
+
+/**
+ * Finish (and in write mode flush) the packed file P, F is not closed. */
+extern int free_truf_pack(truf_pack_t p);
+
+/**
+ * Append the decoded quote line ST to P. */
+extern int truf_pack_add(truf_pack_t p, const struct truf_step_s *st);
+
+/**
+ * Decode the next line of P into ST (sym, t, bid, ask, vol, opi only).
+ * Return 0 on success, -1 if there are no more lines and -2 if P is
+ * truncated or corrupt. */
+extern int truf_pack_next(truf_pack_t p, struct truf_step_s *st);
+
+#endif	/* INCLUDED_pack_h_ */
@@ -0,0 +1,449 @@
+/*** rdr.c -- line readers for echs files
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#if defined USE_READAHEAD
+# include <pthread.h>
+#endif	/* USE_READAHEAD */
+#include "rdr.h"
+#include "tok.h"
+#include "nifty.h"
+
+struct truf_rdr_s {
+	FILE *f;
+	/* mapped file, or NULL if we're in getline() mode */
+	const char *m;
+	/* size of the mapping */
+	size_t z;
+	/* offset of the next line in the mapping */
+	size_t o;
+	/* getline() buffer, in mmap mode used for an unterminated last line */
+	char *line;
+	size_t llen;
+	/* tab offsets of the current line */
+	size_t nf;
+	uint32_t fo[TRUF_TOK_MAXF];
+	/* read-ahead state, or NULL if there's no reading ahead */
+	struct rdr_ra_s *ra;
+	/* the read-ahead buffer we're working on, its size and offset */
+	const char *cb;
+	size_t cz;
+	size_t co;
+};
+
+#if defined USE_READAHEAD
+/* number of buffers and their size, one buffer is with the line reader
+ * the others are being filled meanwhile */
+#define RA_NBUF		(3U)
+#define RA_BSZ		(1024U * 1024U)
+/* leave some room behind the buffers for parsers peeking ahead */
+#define RA_SLACK	(32U)
+
+struct rdr_ra_s {
+	pthread_t th;
+	pthread_mutex_t mtx;
+	pthread_cond_t cnd;
+	int fd;
+	off_t off;
+	/* buffers and their fill levels */
+	char *b[RA_NBUF];
+	size_t n[RA_NBUF];
+	/* number of buffers filled and number of buffers consumed,
+	 * an empty buffer marks the end of the file */
+	unsigned int nfill;
+	unsigned int ncons;
+	/* whether the line reader has buffer NCONS */
+	bool held;
+	bool quit;
+	/* errno of a failed read, 0 if all went well */
+	int err;
+};
+
+static bool rdr_ra_on;
+#endif	/* USE_READAHEAD */
+
+
+static int
+rdr_mmap(truf_rdr_t r)
+{
+	struct stat st;
+	off_t off;
+	int fd;
+	void *m;
+
+	if (UNLIKELY((fd = fileno(r->f)) < 0)) {
+		return -1;
+	} else if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+		/* pipes, ttys, etc. go through getline() */
+		return -1;
+	} else if (st.st_size <= 0) {
+		/* can't map empty files */
+		return -1;
+	} else if ((off = ftello(r->f)) < 0 || off >= st.st_size) {
+		/* nothing left to map */
+		return -1;
+	}
+
+	m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (UNLIKELY(m == MAP_FAILED)) {
+		return -1;
+	}
+#if defined MADV_SEQUENTIAL
+	(void)madvise(m, st.st_size, MADV_SEQUENTIAL);
+#endif	/* MADV_SEQUENTIAL */
+	r->m = m;
+	r->z = st.st_size;
+	/* start where F has been left */
+	r->o = off;
+	return 0;
+}
+
+static ssize_t
+rdr_mmap_line(truf_rdr_t r, const char **ln)
+{
+	const char *sp = r->m + r->o;
+	const size_t rz = r->z - r->o;
+	size_t lz;
+
+	if (UNLIKELY(r->o >= r->z)) {
+		return -1;
+	} else if (LIKELY((lz = truf_tok_line(r->fo, &r->nf, sp, rz)) < rz) ||
+		   LIKELY(sp[rz - 1U] == '\n')) {
+		;
+	} else {
+		/* last line without a newline, we can't peek beyond the
+		 * mapping so copy the line and terminate it properly */
+		if (rz + 2U > r->llen) {
+			r->llen = rz + 2U;
+			r->line = realloc(r->line, r->llen);
+		}
+		memcpy(r->line, sp, rz);
+		r->line[rz + 0U] = '\n';
+		r->line[rz + 1U] = '\0';
+		r->o = r->z;
+		*ln = r->line;
+		return rz;
+	}
+	r->o += lz;
+	*ln = sp;
+	return lz;
+}
+
+#if defined USE_READAHEAD
+static void*
+rdr_ra_thr(void *arg)
+{
+/* the read-ahead thread, fill buffers until there's nothing left */
+	struct rdr_ra_s *ra = arg;
+	bool eof = false;
+
+	while (!eof) {
+		unsigned int i;
+		ssize_t nrd;
+
+		pthread_mutex_lock(&ra->mtx);
+		while (!ra->quit && ra->nfill - ra->ncons >= RA_NBUF) {
+			pthread_cond_wait(&ra->cnd, &ra->mtx);
+		}
+		if (UNLIKELY(ra->quit)) {
+			pthread_mutex_unlock(&ra->mtx);
+			break;
+		}
+		i = ra->nfill % RA_NBUF;
+		pthread_mutex_unlock(&ra->mtx);
+
+		/* no locks needed, buffer I is ours */
+		do {
+			nrd = pread(ra->fd, ra->b[i], RA_BSZ, ra->off);
+		} while (UNLIKELY(nrd < 0) && errno == EINTR);
+		if (UNLIKELY(nrd < 0)) {
+			/* remember the error, the reader sees an end of file
+			 * and free_truf_rdr() reports it */
+			ra->err = errno;
+			nrd = 0;
+			eof = true;
+		} else if (nrd == 0) {
+			eof = true;
+		}
+		ra->off += nrd;
+
+		pthread_mutex_lock(&ra->mtx);
+		ra->n[i] = nrd;
+		ra->nfill++;
+		pthread_cond_signal(&ra->cnd);
+		pthread_mutex_unlock(&ra->mtx);
+	}
+	return NULL;
+}
+
+static int
+rdr_ra(truf_rdr_t r)
+{
+	struct rdr_ra_s *ra;
+	struct stat st;
+	off_t off;
+	int fd;
+
+	if (UNLIKELY((fd = fileno(r->f)) < 0)) {
+		return -1;
+	} else if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+		/* we need to be able to pread() */
+		return -1;
+	} else if ((off = ftello(r->f)) < 0) {
+		return -1;
+	} else if (UNLIKELY((ra = calloc(1, sizeof(*ra))) == NULL)) {
+		return -1;
+	}
+	for (size_t i = 0U; i < RA_NBUF; i++) {
+		if (UNLIKELY((ra->b[i] = malloc(RA_BSZ + RA_SLACK)) == NULL)) {
+			goto nomem;
+		}
+		memset(ra->b[i] + RA_BSZ, 0, RA_SLACK);
+	}
+	ra->fd = fd;
+	ra->off = off;
+	pthread_mutex_init(&ra->mtx, NULL);
+	pthread_cond_init(&ra->cnd, NULL);
+	if (UNLIKELY(pthread_create(&ra->th, NULL, rdr_ra_thr, ra))) {
+		pthread_cond_destroy(&ra->cnd);
+		pthread_mutex_destroy(&ra->mtx);
+		goto nomem;
+	}
+	r->ra = ra;
+	return 0;
+
+nomem:
+	for (size_t i = 0U; i < RA_NBUF; i++) {
+		free(ra->b[i]);
+	}
+	free(ra);
+	return -1;
+}
+
+static int
+rdr_ra_fini(truf_rdr_t r)
+{
+/* stop the read-ahead thread, return its read error, if any */
+	struct rdr_ra_s *ra = r->ra;
+	int err;
+
+	pthread_mutex_lock(&ra->mtx);
+	ra->quit = true;
+	pthread_cond_signal(&ra->cnd);
+	pthread_mutex_unlock(&ra->mtx);
+	pthread_join(ra->th, NULL);
+	err = ra->err;
+
+	pthread_cond_destroy(&ra->cnd);
+	pthread_mutex_destroy(&ra->mtx);
+	for (size_t i = 0U; i < RA_NBUF; i++) {
+		free(ra->b[i]);
+	}
+	free(ra);
+	r->ra = NULL;
+	return err;
+}
+
+static int
+rdr_ra_next(truf_rdr_t r)
+{
+/* give back the current buffer and wait for the next one */
+	struct rdr_ra_s *ra = r->ra;
+	unsigned int i;
+
+	if (UNLIKELY(ra->held && !r->cz)) {
+		/* we're holding the end-of-file buffer already */
+		return -1;
+	}
+	pthread_mutex_lock(&ra->mtx);
+	if (ra->held) {
+		ra->ncons++;
+		ra->held = false;
+		pthread_cond_signal(&ra->cnd);
+	}
+	while (ra->nfill == ra->ncons) {
+		pthread_cond_wait(&ra->cnd, &ra->mtx);
+	}
+	i = ra->ncons % RA_NBUF;
+	r->cb = ra->b[i];
+	r->cz = ra->n[i];
+	r->co = 0U;
+	/* keep hold of the empty end-of-file buffer too */
+	ra->held = true;
+	pthread_mutex_unlock(&ra->mtx);
+	return r->cz > 0U ? 0 : -1;
+}
+
+static ssize_t
+rdr_ra_line(truf_rdr_t r, const char **ln)
+{
+	size_t ll = 0U;
+
+	do {
+		const char *sp;
+		size_t rz;
+		size_t lz;
+
+		if (r->co < r->cz) {
+			;
+		} else if (rdr_ra_next(r) < 0) {
+			break;
+		}
+		sp = r->cb + r->co;
+		rz = r->cz - r->co;
+		lz = truf_tok_line(r->fo, &r->nf, sp, rz);
+		if (LIKELY(!ll) && (lz < rz || sp[lz - 1U] == '\n')) {
+			/* line is complete within the buffer */
+			r->co += lz;
+			*ln = sp;
+			return lz;
+		}
+		/* line continues in the next buffer, or in this one
+		 * if we've been collecting already, stitch it together */
+		if (ll + lz + 2U > r->llen) {
+			r->llen = (ll + lz + 2U) * 2U;
+			r->line = realloc(r->line, r->llen);
+		}
+		memcpy(r->line + ll, sp, lz);
+		r->co += lz;
+		ll += lz;
+	} while (r->line[ll - 1U] != '\n');
+
+	if (UNLIKELY(!ll)) {
+		return -1;
+	} else if (r->line[ll - 1U] != '\n') {
+		/* last line without a newline */
+		r->line[ll + 0U] = '\n';
+		r->line[ll + 1U] = '\0';
+	} else {
+		r->line[ll] = '\0';
+	}
+	(void)truf_tok_line(r->fo, &r->nf, r->line, ll);
+	*ln = r->line;
+	return ll;
+}
+#endif	/* USE_READAHEAD */
+
+
+void
+truf_rdr_readahead(int onp)
+{
+#if defined USE_READAHEAD
+	rdr_ra_on = onp;
+#endif	/* USE_READAHEAD */
+	return;
+}
+
+truf_rdr_t
+make_truf_rdr(FILE *f)
+{
+	truf_rdr_t r;
+
+	if (UNLIKELY((r = calloc(1, sizeof(*r))) == NULL)) {
+		return NULL;
+	}
+	r->f = f;
+#if defined USE_READAHEAD
+	if (rdr_ra_on && rdr_ra(r) >= 0) {
+		return r;
+	}
+#endif	/* USE_READAHEAD */
+	(void)rdr_mmap(r);
+	return r;
+}
+
+int
+free_truf_rdr(truf_rdr_t r)
+{
+	int err = 0;
+
+#if defined USE_READAHEAD
+	if (r->ra != NULL) {
+		err = rdr_ra_fini(r);
+	}
+#endif	/* USE_READAHEAD */
+	if (r->m != NULL) {
+		munmap(deconst(r->m), r->z);
+	}
+	if (r->line != NULL) {
+		free(r->line);
+	}
+	free(r);
+	if (UNLIKELY(err)) {
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
+
+ssize_t
+truf_rdr_line(truf_rdr_t r, const char **ln)
+{
+	ssize_t nrd;
+
+	if (r->m != NULL) {
+		return rdr_mmap_line(r, ln);
+#if defined USE_READAHEAD
+	} else if (r->ra != NULL) {
+		return rdr_ra_line(r, ln);
+#endif	/* USE_READAHEAD */
+	} else if ((nrd = getline(&r->line, &r->llen, r->f)) <= 0) {
+		return -1;
+	}
+	(void)truf_tok_line(r->fo, &r->nf, r->line, nrd);
+	*ln = r->line;
+	return nrd;
+}
+
+const uint32_t*
+truf_rdr_tabs(truf_rdr_t r, size_t *nf)
+{
+	*nf = r->nf;
+	return r->fo;
+}
+
+/* rdr.c ends here */
@@ -0,0 +1,78 @@
+/*** rdr.h -- line readers for echs files
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_rdr_h_
+#define INCLUDED_rdr_h_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef struct truf_rdr_s *truf_rdr_t;
+
+
+/**
+ * Return a line reader for F, starting at F's current position.
+ * Regular files are memory-mapped and lines are handed out as pointers
+ * into the mapping, anything else (pipes, ttys) is read through getline().
+ * With read-ahead switched on, regular files are read by a background
+ * thread instead, while the lines of the previous read are parsed. */
+extern truf_rdr_t make_truf_rdr(FILE *f);
+
+/**
+ * Switch read-ahead on (ONP != 0) or off for readers made from now on.
+ * This is a no-op if truffle has been built without thread support. */
+extern void truf_rdr_readahead(int onp);
+
+/**
+ * Free resources associated with line reader R, F is not closed.
+ * Return -1 and set errno if reading ahead failed, 0 otherwise. */
+extern int free_truf_rdr(truf_rdr_t r);
+
+/**
+ * Point LN to the next line of R and return its length including the
+ * newline character, or return -1 if there are no more lines.
+ * Lines are not necessarily \nul-terminated but they are guaranteed
+ * to end in either a newline or a \nul character. */
+extern ssize_t truf_rdr_line(truf_rdr_t r, const char **ln);
+
+/**
+ * Return the offsets of the tab characters in the line last obtained
+ * through truf_rdr_line() and store their number in NF. */
+extern const uint32_t *truf_rdr_tabs(truf_rdr_t r, size_t *nf);
+
+#endif	/* INCLUDED_rdr_h_ */
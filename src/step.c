@@ -37,118 +37,166 @@
 #if defined HAVE_CONFIG_H
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 #include "step.h"
 #include "nifty.h"
 
-/* the beef table, slot 0-63 are in stkstk[0U], slots 64-127 in stkstk[1U],
- * slots 128-256 in stkstk[2U], etc. */
+/* the beef, steps 0-63 are in stkstk[0U], steps 64-191 in stkstk[1U],
+ * steps 192-447 in stkstk[2U], etc.; steps never move once created,
+ * step 0 is reserved for the special NOSYM symbol */
 static struct truf_step_s inistk[64U];
-static truf_step_t stkstk[64U] = {inistk};
-/* alloc size, index of next stkstk */
-static size_t zstk;
-/* number of elements */
+static truf_step_t stkstk[48U] = {inistk};
+/* number of steps */
 static size_t nstk;
 
-static inline __attribute__((always_inline)) unsigned int
-fls(unsigned int x)
+/* Robin Hood hash table mapping symbols to step indices, DIB is the
+ * distance of the slot to the symbol's home slot, 0 symbols are free */
+static struct hx_s {
+	truf_sym_t sym;
+	uint32_t idx;
+	uint32_t dib;
+} *hx;
+/* table size (a 2-power) and number of symbols in the table */
+static size_t zhx;
+static size_t nhx;
+
+static inline __attribute__((const)) size_t
+hx_home(truf_sym_t sym, size_t z)
 {
-	return x ? sizeof(x) * 8U - __builtin_clz(x) : 0U;
+/* fibonacci hashing, use the high bits of the product */
+	return (size_t)(((uint64_t)sym.u * 0x9e3779b97f4a7c15ULL) >>
+			(64U - __builtin_ctzll(z)));
 }
 
-static inline struct stk_off_s {
-	/* which stack */
-	size_t stk;
-	/* which cell */
-	size_t cel;
-} decomp(size_t x)
+static inline __attribute__((const)) unsigned int
+stk_blk(size_t i)
 {
-	size_t log2 = fls(x);
+/* block of step I, the steps of block B start at (2^B - 1) * 64 */
+	return 63U - __builtin_clzll(i / 64U + 1U);
+}
 
-	if (log2-- <= 6U) {
-		return (struct stk_off_s){0U, x};
-	}
-	return (struct stk_off_s){log2 - 5U, x % (1U << log2)};
+static inline truf_step_t
+stk_step(size_t i)
+{
+	const unsigned int b = stk_blk(i);
+
+	return stkstk[b] + (i - ((1ULL << b) - 1U) * 64U);
 }
 
-static inline struct stk_off_s
-get_off(size_t idx, size_t mod)
+static truf_step_t
+make_step(truf_sym_t sym)
 {
-	/* no need to negate MOD as it's a 2-power */
-	return decomp(-idx % mod);
+/* create a new step for SYM at the end of the blocks */
+	const unsigned int b = stk_blk(nstk);
+	const size_t z = (size_t)64U << b;
+	truf_step_t st;
+
+	if (UNLIKELY(stkstk[b] == NULL) &&
+	    UNLIKELY((stkstk[b] = malloc(z * sizeof(**stkstk))) == NULL)) {
+		return NULL;
+	}
+	st = stk_step(nstk++);
+	*st = (struct truf_step_s){
+		.sym = sym,
+		/* no prices yet */
+		.bid = NANPX, .ask = NANPX,
+		/* no exposures either */
+		.old = ZEROEX, .new = ZEROEX,
+	};
+	return st;
 }
 
 static void
-init(struct stk_off_s o, truf_sym_t sym)
+hx_ins(struct hx_s c)
 {
-	stkstk[o.stk][o.cel].sym = sym;
-	/* no prices yet */
-	stkstk[o.stk][o.cel].bid = stkstk[o.stk][o.cel].ask = NANPX;
-	/* no exposures either */
-	stkstk[o.stk][o.cel].old = stkstk[o.stk][o.cel].new = ZEROEX;
+/* put C into the table, taking slots from the rich */
+	const size_t mask = zhx - 1U;
+
+	for (size_t i = hx_home(c.sym, zhx);; i = (i + 1U) & mask, c.dib++) {
+		if (!hx[i].sym.u) {
+			hx[i] = c;
+			break;
+		} else if (hx[i].dib < c.dib) {
+			struct hx_s tmp = hx[i];
+			hx[i] = c;
+			c = tmp;
+		}
+	}
+	nhx++;
 	return;
 }
 
-
+static int
+hx_resz(size_t nu)
+{
+	struct hx_s *o = hx;
+	const size_t oz = zhx;
+
+	if (UNLIKELY((hx = calloc(nu, sizeof(*hx))) == NULL)) {
+		hx = o;
+		return -1;
+	}
+	zhx = nu;
+	nhx = 0U;
+	for (size_t i = 0U; i < oz; i++) {
+		if (o[i].sym.u) {
+			hx_ins((struct hx_s){
+					.sym = o[i].sym, .idx = o[i].idx,
+					.dib = 0U});
+		}
+	}
+	free(o);
+	return 0;
+}
+
+
 truf_step_t
 truf_step_find(truf_sym_t sym)
 {
-	size_t hx = truf_sym_hx(sym);
-	size_t mod = 64U;
-
-	while (1) {
-		/* just try what we've got */
-		for (; mod <= (64U << zstk); mod *= 2U) {
-			struct stk_off_s o = get_off(hx, mod);
-
-			if (UNLIKELY(!sym.u) ||
-			    LIKELY(stkstk[o.stk][o.cel].sym.u == sym.u)) {
-				/* found him */
-				return stkstk[o.stk] + o.cel;
-			} else if (stkstk[o.stk][o.cel].sym.u == 0U) {
-				/* found empty slot */
-				init(o, sym);
-				nstk++;
-				return stkstk[o.stk] + o.cel;
-			}
-		}
-		/* quite a lot of collisions, resize then */
-		with (size_t sz = (64U << zstk)) {
-			stkstk[++zstk] = calloc(sz, sizeof(**stkstk));
+	const size_t mask = zhx - 1U;
+	truf_step_t st;
+
+	if (UNLIKELY(!sym.u)) {
+		return stkstk[0U];
+	}
+	for (size_t i = hx_home(sym, zhx), d = 0U;; i = (i + 1U) & mask, d++) {
+		if (LIKELY(hx[i].sym.u == sym.u)) {
+			/* found him */
+			return stk_step(hx[i].idx);
+		} else if (!hx[i].sym.u || hx[i].dib < d) {
+			/* he'd have been here by now */
+			break;
 		}
 	}
+	/* not found, keep the load factor below 3/4 */
+	if (UNLIKELY(4U * (nhx + 1U) > 3U * zhx) &&
+	    UNLIKELY(hx_resz(2U * zhx) < 0)) {
+		return NULL;
+	} else if (UNLIKELY((st = make_step(sym)) == NULL)) {
+		return NULL;
+	}
+	hx_ins((struct hx_s){
+			.sym = sym, .idx = (uint32_t)(nstk - 1U), .dib = 0U});
+	return st;
 }
 
 truf_step_t
 truf_step_iter(void)
 {
-/* coroutine with static storage */
-	static size_t s;
+/* coroutine with static storage, steps come in order of creation */
 	static size_t i;
 
-	if (s == 0U) {
-		while (i < 64U) {
-			size_t this = i++;
-			if (stkstk[s][this].sym.u) {
-				return stkstk[s] + this;
-			}
-		}
-		s++;
-		i = 0U;
-	}
-	while (s <= zstk) {
-		while (i < (64U << (s - 1U))) {
-			size_t this = i++;
-			if (stkstk[s][this].sym.u) {
-				return stkstk[s] + this;
-			}
+	while (i < nstk) {
+		truf_step_t st = stk_step(i++);
+
+		if (st->sym.u) {
+			return st;
 		}
-		s++;
-		i = 0U;
 	}
 	/* reset offsets for next iteration */
-	s = 0U;
+	i = 0U;
 	return NULL;
 }
 
@@ -156,21 +204,30 @@ void
 truf_init_step(void)
 {
 	nstk = 0U;
-	zstk = 0U;
+	if (hx == NULL) {
+		zhx = 64U;
+		hx = calloc(zhx, sizeof(*hx));
+	} else {
+		memset(hx, 0, zhx * sizeof(*hx));
+	}
+	nhx = 0U;
 
 	/* initialise the first slot for special NOSYM symbol */
-	init((struct stk_off_s){0U, 0U}, (truf_sym_t){0U});
+	make_step((truf_sym_t){0U});
 	return;
 }
 
 void
 truf_fini_step(void)
 {
-	for (size_t i = 1U; i <= zstk; i++) {
-		free(stkstk[i]);
+	for (size_t b = 1U; b < countof(stkstk) && stkstk[b] != NULL; b++) {
+		free(stkstk[b]);
+		stkstk[b] = NULL;
 	}
-	zstk = 0U;
 	nstk = 0U;
+	free(hx);
+	hx = NULL;
+	zhx = nhx = 0U;
 	return;
 }
 
@@ -0,0 +1,357 @@
+/*** tcache.c -- compiled trod file caches
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "tcache.h"
+#include "nifty.h"
+
+#define TCACHE_VERSION	(1U)
+#define TCACHE_BOM	(0x01020304U)
+#if defined HAVE_DFP754_BID_LITERALS
+# define TCACHE_ENC	((uint32_t)'b')
+#elif defined HAVE_DFP754_DPD_LITERALS
+# define TCACHE_ENC	((uint32_t)'d')
+#endif	/* HAVE_DFP754_*_LITERALS */
+
+struct tcache_hdr_s {
+	char magic[7U];
+	uint8_t version;
+	/* byte order mark */
+	uint32_t bom;
+	/* decimal encoding */
+	uint32_t enc;
+	/* number of directives and strings, size of the string table */
+	uint32_t ntrod;
+	uint32_t nstr;
+	uint32_t strz;
+	/* the trod file this is a cache of */
+	int64_t size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+};
+
+/* directives are followed by the string table, each string being
+ * a length byte followed by the characters */
+struct tcache_trod_s {
+	uint64_t t;
+	/* 0 for no symbol, odd for mmys, even for the (n+1)-th string */
+	uint32_t sym[2U];
+	truf_expos_t exp;
+};
+
+struct truf_tcache_s {
+	void *m;
+	size_t mz;
+	const struct tcache_trod_s *d;
+	size_t n;
+	/* the strings of the string table, interned */
+	truf_str_t *strs;
+	size_t nstr;
+};
+
+static const char magic[7U] = "\x7ftrufct";
+
+
+static char*
+tcache_fn(const char *fn)
+{
+	const size_t fz = strlen(fn);
+	char *res;
+
+	if (LIKELY((res = malloc(fz + sizeof(".cache"))) != NULL)) {
+		memcpy(res, fn, fz);
+		memcpy(res + fz, ".cache", sizeof(".cache"));
+	}
+	return res;
+}
+
+static inline truf_sym_t
+tcache_sym(truf_tcache_t c, uint32_t s)
+{
+	if (!s) {
+		return (truf_sym_t){0U};
+	} else if (s & 0b1U) {
+		return (truf_sym_t){.mmy = (int32_t)s};
+	} else if (LIKELY((s >>= 1U) <= c->nstr)) {
+		return (truf_sym_t){.str = c->strs[s - 1U]};
+	}
+	return (truf_sym_t){0U};
+}
+
+
+truf_tcache_t
+truf_tcache_open(const char *fn)
+{
+	const struct tcache_hdr_s *h;
+	struct truf_tcache_s *c;
+	struct stat st, cst;
+	char *cfn;
+	int fd;
+
+	if (UNLIKELY(stat(fn, &st) < 0 || !S_ISREG(st.st_mode))) {
+		return NULL;
+	} else if (UNLIKELY((cfn = tcache_fn(fn)) == NULL)) {
+		return NULL;
+	}
+	fd = open(cfn, O_RDONLY);
+	free(cfn);
+	if (fd < 0) {
+		return NULL;
+	} else if (UNLIKELY(fstat(fd, &cst) < 0 ||
+			    (size_t)cst.st_size < sizeof(*h))) {
+		goto clo;
+	} else if (UNLIKELY((c = malloc(sizeof(*c))) == NULL)) {
+		goto clo;
+	}
+	c->mz = cst.st_size;
+	c->m = mmap(NULL, c->mz, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (UNLIKELY(c->m == MAP_FAILED)) {
+		goto fre;
+	}
+	h = c->m;
+	if (memcmp(h->magic, magic, sizeof(magic)) ||
+	    h->version != TCACHE_VERSION ||
+	    h->bom != TCACHE_BOM || h->enc != TCACHE_ENC) {
+		/* not ours */
+		goto unm;
+	} else if (h->size != st.st_size ||
+		   h->mtime_sec != st.st_mtim.tv_sec ||
+		   h->mtime_nsec != st.st_mtim.tv_nsec) {
+		/* stale */
+		goto unm;
+	} else if (c->mz != sizeof(*h) +
+		   h->ntrod * sizeof(*c->d) + h->strz) {
+		/* truncated */
+		goto unm;
+	}
+	c->d = (const void*)(h + 1U);
+	c->n = h->ntrod;
+	c->nstr = h->nstr;
+	if (UNLIKELY((c->strs = malloc(c->nstr * sizeof(*c->strs))) == NULL &&
+		     c->nstr)) {
+		goto unm;
+	}
+	/* intern the string table */
+	with (const uint8_t *sp = (const void*)(c->d + c->n)) {
+		const uint8_t *const ep = sp + h->strz;
+
+		for (size_t i = 0U; i < c->nstr; i++, sp += 1U + *sp) {
+			if (UNLIKELY(sp >= ep || sp + 1U + *sp > ep)) {
+				free(c->strs);
+				goto unm;
+			}
+			c->strs[i] = truf_str_intern((const char*)sp + 1U, *sp);
+		}
+	}
+	close(fd);
+	return c;
+
+unm:
+	munmap(c->m, c->mz);
+fre:
+	free(c);
+clo:
+	close(fd);
+	return NULL;
+}
+
+void
+truf_tcache_close(truf_tcache_t c)
+{
+	munmap(c->m, c->mz);
+	free(c->strs);
+	free(c);
+	return;
+}
+
+size_t
+truf_tcache_ntrods(truf_tcache_t c)
+{
+	return c->n;
+}
+
+truf_trod_t
+truf_tcache_trod(truf_tcache_t c, size_t i, echs_instant_t *t)
+{
+	const struct tcache_trod_s *d = c->d + i;
+
+	*t = (echs_instant_t){.u = d->t};
+	return (truf_trod_t){
+		.sym[0U] = tcache_sym(c, d->sym[0U]),
+		.sym[1U] = tcache_sym(c, d->sym[1U]),
+		.exp = d->exp,
+	};
+}
+
+int
+truf_tcache_wr(const char *fn,
+	       const echs_instant_t *t, const truf_trod_t *d, size_t n)
+{
+	struct tcache_hdr_s h = {
+		.version = TCACHE_VERSION,
+		.bom = TCACHE_BOM,
+		.enc = TCACHE_ENC,
+		.ntrod = (uint32_t)n,
+	};
+	/* string symbol to table index map, 2-power sized */
+	struct {
+		truf_str_t str;
+		uint32_t idx;
+	} *map = NULL;
+	size_t zmap = 0U;
+	truf_str_t *strs = NULL;
+	struct stat st;
+	char *cfn = NULL, *tfn = NULL;
+	FILE *f = NULL;
+	int rc = -1;
+
+	if (UNLIKELY(stat(fn, &st) < 0 || !S_ISREG(st.st_mode))) {
+		return -1;
+	} else if (UNLIKELY(n > UINT32_MAX)) {
+		return -1;
+	} else if (UNLIKELY((cfn = tcache_fn(fn)) == NULL)) {
+		return -1;
+	} else if (UNLIKELY((tfn = malloc(strlen(cfn) + 5U)) == NULL)) {
+		goto out;
+	}
+	h.size = st.st_size;
+	h.mtime_sec = st.st_mtim.tv_sec;
+	h.mtime_nsec = st.st_mtim.tv_nsec;
+	memcpy(h.magic, magic, sizeof(magic));
+
+	/* write to a temporary and move it into place when done */
+	strcpy(tfn, cfn);
+	strcat(tfn, ".tmp");
+	if (UNLIKELY((f = fopen(tfn, "w")) == NULL)) {
+		goto out;
+	} else if (UNLIKELY(fwrite(&h, sizeof(h), 1U, f) < 1U)) {
+		goto out;
+	}
+	for (size_t i = 0U; i < n; i++) {
+		struct tcache_trod_s r = {.t = t[i].u, .exp = d[i].exp};
+
+		for (size_t j = 0U; j < countof(d->sym); j++) {
+			truf_sym_t s = d[i].sym[j];
+			size_t k;
+
+			if (!truf_str_p(s)) {
+				/* mmys and nothings are stored as is */
+				r.sym[j] = (uint32_t)s.u;
+				continue;
+			} else if (UNLIKELY(2U * h.nstr >= zmap)) {
+				/* resize and rehash */
+				const size_t ozmap = zmap;
+				typeof(map) omap = map;
+
+				zmap = zmap ? 2U * zmap : 64U;
+				if (UNLIKELY((map = calloc(
+						      zmap,
+						      sizeof(*map))) == NULL)) {
+					free(omap);
+					goto out;
+				}
+				for (size_t x = 0U; x < ozmap; x++) {
+					if (!omap[x].str) {
+						continue;
+					}
+					k = omap[x].str % zmap;
+					while (map[k].str) {
+						k = (k + 1U) % zmap;
+					}
+					map[k] = omap[x];
+				}
+				free(omap);
+				strs = realloc(strs, zmap / 2U * sizeof(*strs));
+				if (UNLIKELY(strs == NULL)) {
+					goto out;
+				}
+			}
+			for (k = s.str % zmap;
+			     map[k].str && map[k].str != s.str;
+			     k = (k + 1U) % zmap);
+			if (!map[k].str) {
+				map[k].str = s.str;
+				map[k].idx = h.nstr;
+				strs[h.nstr++] = s.str;
+			}
+			r.sym[j] = (map[k].idx + 1U) << 1U;
+		}
+		if (UNLIKELY(fwrite(&r, sizeof(r), 1U, f) < 1U)) {
+			goto out;
+		}
+	}
+	/* string table */
+	for (size_t i = 0U; i < h.nstr; i++) {
+		char buf[256U];
+		uint8_t z = (uint8_t)truf_str_wr(buf, sizeof(buf), strs[i]);
+
+		fputc(z, f);
+		fwrite(buf, 1U, z, f);
+		h.strz += 1U + z;
+	}
+	/* now that we know about the strings, rewrite the header */
+	if (UNLIKELY(fseeko(f, 0, SEEK_SET) < 0)) {
+		goto out;
+	} else if (UNLIKELY(fwrite(&h, sizeof(h), 1U, f) < 1U)) {
+		goto out;
+	}
+	rc = 0;
+out:
+	if (f != NULL && (fclose(f) < 0 || rc < 0)) {
+		unlink(tfn);
+		rc = -1;
+	} else if (f != NULL && rename(tfn, cfn) < 0) {
+		unlink(tfn);
+		rc = -1;
+	}
+	free(map);
+	free(strs);
+	free(tfn);
+	free(cfn);
+	return rc;
+}
+
+/* tcache.c ends here */
@@ -0,0 +1,79 @@
+/*** tcache.h -- compiled trod file caches
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_tcache_h_
+#define INCLUDED_tcache_h_
+
+#include <stdlib.h>
+#include "instant.h"
+#include "trod.h"
+
+/**
+ * Trod caches are binary snapshots of a trod file's directives, kept
+ * next to the trod file as FILE.cache and only used while the trod
+ * file's size and modification time match those recorded in the cache.
+ * The cache holds the directives (in file order) along with their time
+ * stamps and a table of the string symbols used.
+ *
+ * Byte order and decimal encoding are those of the writing host. */
+typedef struct truf_tcache_s *truf_tcache_t;
+
+
+/**
+ * Map the cache of trod file FN.
+ * Return NULL if there is no cache or if it's stale. */
+extern truf_tcache_t truf_tcache_open(const char *fn);
+
+/**
+ * Unmap the cache C. */
+extern void truf_tcache_close(truf_tcache_t c);
+
+/**
+ * Return the number of directives in C. */
+extern size_t truf_tcache_ntrods(truf_tcache_t c);
+
+/**
+ * Return the I-th directive of C and store its time stamp in T. */
+extern truf_trod_t
+truf_tcache_trod(truf_tcache_t c, size_t i, echs_instant_t *t);
+
+/**
+ * Write a cache for trod file FN with the N directives D stamped T. */
+extern int
+truf_tcache_wr(const char *fn,
+	       const echs_instant_t *t, const truf_trod_t *d, size_t n);
+
+#endif	/* INCLUDED_tcache_h_ */
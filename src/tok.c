@@ -0,0 +1,184 @@
+/*** tok.c -- tab/newline tokeniser for echs lines
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include "tok.h"
+#include "nifty.h"
+
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+# include <immintrin.h>
+# define HAVE_X86_SIMD
+#endif	/* __GNUC__ && x86 */
+
+typedef size_t(*tok_f)(uint32_t*, size_t*, const char*, size_t);
+
+
+static size_t
+tok_tail(uint32_t fo[static TRUF_TOK_MAXF], size_t *nf,
+	 const char *s, size_t i, size_t z)
+{
+/* scalar scan of S from offset I on, *NF tabs have been seen already */
+	size_t n = *nf;
+
+	for (; i < z; i++) {
+		switch (s[i]) {
+		case '\t':
+			if (LIKELY(n < TRUF_TOK_MAXF)) {
+				fo[n++] = i;
+			}
+			break;
+		case '\n':
+			*nf = n;
+			return i + 1U;
+		default:
+			break;
+		}
+	}
+	*nf = n;
+	return z;
+}
+
+static size_t
+tok_line_scal(uint32_t fo[static TRUF_TOK_MAXF], size_t *nf,
+	      const char *s, size_t z)
+{
+	*nf = 0U;
+	return tok_tail(fo, nf, s, 0U, z);
+}
+
+#if defined HAVE_X86_SIMD
+/* The vector versions compare whole blocks against \t and \n at once
+ * and turn the results into bit masks T and N.  Tab bits below the
+ * first newline bit are handed out as field separators.  Blocks that
+ * would cross the end of S are left to the scalar tail. */
+static inline size_t
+tok_mask(uint32_t fo[static TRUF_TOK_MAXF], size_t *nf,
+	 size_t off, uint32_t T, uint32_t N)
+{
+	size_t n = *nf;
+
+	if (N) {
+		/* only keep tabs before the newline */
+		T &= (N & -N) - 1U;
+	}
+	for (; T && n < TRUF_TOK_MAXF; T &= T - 1U) {
+		fo[n++] = off + __builtin_ctz(T);
+	}
+	*nf = n;
+	return N ? off + __builtin_ctz(N) + 1U : 0U;
+}
+
+static __attribute__((target("sse2"))) size_t
+tok_line_sse2(uint32_t fo[static TRUF_TOK_MAXF], size_t *nf,
+	      const char *s, size_t z)
+{
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i nl = _mm_set1_epi8('\n');
+	size_t i;
+
+	*nf = 0U;
+	for (i = 0U; i + sizeof(__m128i) <= z; i += sizeof(__m128i)) {
+		__m128i x = _mm_loadu_si128((const void*)(s + i));
+		uint32_t T = _mm_movemask_epi8(_mm_cmpeq_epi8(x, tab));
+		uint32_t N = _mm_movemask_epi8(_mm_cmpeq_epi8(x, nl));
+		size_t eol;
+
+		if ((eol = tok_mask(fo, nf, i, T, N))) {
+			return eol;
+		}
+	}
+	return tok_tail(fo, nf, s, i, z);
+}
+
+static __attribute__((target("avx2"))) size_t
+tok_line_avx2(uint32_t fo[static TRUF_TOK_MAXF], size_t *nf,
+	      const char *s, size_t z)
+{
+	const __m256i tab = _mm256_set1_epi8('\t');
+	const __m256i nl = _mm256_set1_epi8('\n');
+	size_t i;
+
+	*nf = 0U;
+	for (i = 0U; i + sizeof(__m256i) <= z; i += sizeof(__m256i)) {
+		__m256i x = _mm256_loadu_si256((const void*)(s + i));
+		uint32_t T = _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, tab));
+		uint32_t N = _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, nl));
+		size_t eol;
+
+		if ((eol = tok_mask(fo, nf, i, T, N))) {
+			return eol;
+		}
+	}
+	return tok_tail(fo, nf, s, i, z);
+}
+#endif	/* HAVE_X86_SIMD */
+
+static size_t
+tok_line_init(uint32_t fo[static TRUF_TOK_MAXF], size_t *nf,
+	      const char *s, size_t z);
+
+/* resolved upon first use */
+static tok_f tok_line = tok_line_init;
+
+static size_t
+tok_line_init(uint32_t fo[static TRUF_TOK_MAXF], size_t *nf,
+	      const char *s, size_t z)
+{
+	tok_line = tok_line_scal;
+#if defined HAVE_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		tok_line = tok_line_avx2;
+	} else if (__builtin_cpu_supports("sse2")) {
+		tok_line = tok_line_sse2;
+	}
+#endif	/* HAVE_X86_SIMD */
+	return tok_line(fo, nf, s, z);
+}
+
+
+size_t
+truf_tok_line(uint32_t fo[static TRUF_TOK_MAXF], size_t *nf,
+	      const char *s, size_t z)
+{
+	return tok_line(fo, nf, s, z);
+}
+
+/* tok.c ends here */
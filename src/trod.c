@@ -59,6 +59,9 @@ truf_trod_rd(const char *str, char **on)
 	truf_trod_t res;
 	const char *brk;
 	const char *st2 = NULL;
+	/* left side of X->Y, lines needn't be writable nor \nul-terminated,
+	 * any longer and it can't be a mmy */
+	char st1[64U];
 
 	switch (*(brk += strcspn(brk = str, sep))) {
 		char *p;
@@ -70,10 +73,21 @@ truf_trod_rd(const char *str, char **on)
 			/* could be ~FOO notation */
 			res.exp = ZEROEX;
 			str++;
-		} else if ((p = strchr(str, '>')) && p[-1] == '-') {
+		} else if ((p = memchr(str, '>', brk - str)) &&
+			   p > str && p[-1] == '-') {
 			/* syntax X->Y */
+			size_t len = p - 1U - str;
+
+			if (UNLIKELY(len >= sizeof(st1))) {
+				/* intern it as is, no need for a copy */
+				res.sym[0U].str = truf_str_intern(str, len);
+				str = NULL;
+			} else {
+				memcpy(st1, str, len);
+				st1[len] = '\0';
+				str = st1;
+			}
 			res.exp = ZEROEX;
-			p[-1] = '\0';
 			st2 = p + 1U;
 		} else {
 			res.exp = UNITEX;
@@ -91,7 +105,9 @@ truf_trod_rd(const char *str, char **on)
 	/* before blindly strdup()ing the symbol check if it's not by
 	 * any chance in MMY notation
 	 * thankfully the mmy subsystem does the magic for us. */
-	res.sym[0U] = truf_sym_rd(str, NULL);
+	if (LIKELY(str != NULL)) {
+		res.sym[0U] = truf_sym_rd(str, NULL);
+	}
 	res.sym[1U] = truf_sym_rd(st2, NULL);
 	return res;
 }
@@ -0,0 +1,145 @@
+/*** trods.c -- stores of trod directives
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include "trods.h"
+#include "nifty.h"
+
+/* block B holds TRODS_BLKZ << B directives */
+#define TRODS_BLKZ	(64U)
+#define TRODS_NBLK	(48U)
+
+struct truf_trods_s {
+	/** number of directives ever added, handles below that are taken */
+	size_t n;
+	/** blocks, doubling in size */
+	truf_trod_t *blk[TRODS_NBLK];
+	/** released handles */
+	uintptr_t *fr;
+	size_t nfr;
+	size_t zfr;
+};
+
+
+static inline __attribute__((const)) unsigned int
+trods_blk(uintptr_t h)
+{
+/* block of handle H, the handles of block B start at (2^B - 1) * 64 */
+	return 63U - __builtin_clzll(h / TRODS_BLKZ + 1U);
+}
+
+static inline __attribute__((const)) size_t
+trods_off(uintptr_t h, unsigned int b)
+{
+	return h - ((1ULL << b) - 1U) * TRODS_BLKZ;
+}
+
+
+truf_trods_t
+make_truf_trods(void)
+{
+	return calloc(1U, sizeof(struct truf_trods_s));
+}
+
+void
+free_truf_trods(truf_trods_t s)
+{
+	for (size_t b = 0U; b < countof(s->blk) && s->blk[b] != NULL; b++) {
+		free(s->blk[b]);
+	}
+	if (s->fr != NULL) {
+		free(s->fr);
+	}
+	free(s);
+	return;
+}
+
+uintptr_t
+truf_trods_add(truf_trods_t s, truf_trod_t d)
+{
+	uintptr_t h;
+	unsigned int b;
+
+	if (s->nfr) {
+		/* recycle a released slot */
+		h = s->fr[--s->nfr];
+		b = trods_blk(h);
+	} else if (UNLIKELY((b = trods_blk(h = s->n)) >= countof(s->blk))) {
+		return UINTPTR_MAX;
+	} else if (UNLIKELY(s->blk[b] == NULL) &&
+		   UNLIKELY((s->blk[b] = malloc(
+				     ((size_t)TRODS_BLKZ << b) *
+				     sizeof(d))) == NULL)) {
+		/* first directive of a new block, but no memory */
+		return UINTPTR_MAX;
+	} else {
+		s->n++;
+	}
+	s->blk[b][trods_off(h, b)] = d;
+	return h;
+}
+
+const truf_trod_t*
+truf_trods_get(truf_trods_t s, uintptr_t h)
+{
+	const unsigned int b = trods_blk(h);
+
+	return s->blk[b] + trods_off(h, b);
+}
+
+void
+truf_trods_rel(truf_trods_t s, uintptr_t h)
+{
+	if (UNLIKELY(s->nfr >= s->zfr)) {
+		const size_t nu = s->zfr ? 2U * s->zfr : TRODS_BLKZ;
+		uintptr_t *fr;
+
+		if (UNLIKELY((fr = realloc(s->fr, nu * sizeof(*fr))) == NULL)) {
+			/* just leak the slot then */
+			return;
+		}
+		s->fr = fr;
+		s->zfr = nu;
+	}
+	s->fr[s->nfr++] = h;
+	return;
+}
+
+/* trods.c ends here */
@@ -0,0 +1,66 @@
+/*** trods.h -- stores of trod directives
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_trods_h_
+#define INCLUDED_trods_h_
+
+#include <stdint.h>
+#include "trod.h"
+
+/**
+ * Trod stores hold directives on behalf of wheaps, which only carry
+ * a uintptr_t handle per cell.  Directives are kept in blocks of
+ * doubling size that are never moved, so pointers to directives stay
+ * valid for the lifetime of the store. */
+typedef struct truf_trods_s *truf_trods_t;
+
+
+extern truf_trods_t make_truf_trods(void);
+extern void free_truf_trods(truf_trods_t);
+
+/**
+ * Put a copy of directive D into S, return its handle. */
+extern uintptr_t truf_trods_add(truf_trods_t s, truf_trod_t d);
+
+/**
+ * Return the directive with handle H in S. */
+extern const truf_trod_t *truf_trods_get(truf_trods_t s, uintptr_t h);
+
+/**
+ * Release the directive with handle H, its slot will be reused. */
+extern void truf_trods_rel(truf_trods_t s, uintptr_t h);
+
+#endif	/* INCLUDED_trods_h_ */
@@ -46,6 +46,8 @@
 #include <string.h>
 #include <errno.h>
 #include <assert.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #if defined HAVE_DFP754_H
 # include <dfp754.h>
 #elif defined HAVE_DFP_STDLIB_H
@@ -61,6 +63,15 @@ extern int isinfd64(_Decimal64);
 #include "trod.h"
 #include "step.h"
 #include "rpaf.h"
+#include "rdr.h"
+#include "dcmp.h"
+#include "tok.h"
+#include "pack.h"
+#include "idx.h"
+#include "wrr.h"
+#include "bin.h"
+#include "tcache.h"
+#include "trods.h"
 /* while we're in transition mood */
 #include "daisy.h"
 #include "idate.h"
@@ -78,6 +89,10 @@ extern int isinfd64(_Decimal64);
 typedef const struct truf_step_s *truf_step_cell_t;
 
 static int rc;
+/* how far time series lines may be out of order, 0 if not at all */
+static echs_idiff_t reorder_window;
+/* where co_echs_out and co_roll_out write to */
+static truf_wrr_t wrr;
 
 
 static void
@@ -143,43 +158,100 @@ fls(unsigned int x)
 
 
 /* trod directives cache */
-static truf_trod_t *trods;
-static size_t ntrods;
-static size_t trodi;
+static truf_trods_t trods;
+/* whether to use compiled trod caches, see tcache.h */
+static bool trod_cache;
+/* whether to read trod files lazily, and the files in question */
+static bool trod_strm;
+static struct trod_strm_s {
+	const char *fn;
+	FILE *f;
+	truf_rdr_t r;
+	/* the next directive line, past its stamp T */
+	echs_instant_t t;
+	const char *ln;
+} *strms;
+static size_t nstrms;
 
 static int
 truf_add_trod(truf_wheap_t q, echs_instant_t t, truf_trod_t d)
 {
 	uintptr_t qmsg;
 
-	/* resize check */
-	if (trodi >= ntrods) {
-		size_t nu = ntrods + 64U;
-		trods = realloc(trods, nu * sizeof(*trods));
-		ntrods = nu;
+	if (UNLIKELY(trods == NULL) &&
+	    UNLIKELY((trods = make_truf_trods()) == NULL)) {
+		return -1;
+	} else if (UNLIKELY((qmsg = truf_trods_add(trods, d)) == UINTPTR_MAX)) {
+		/* couldn't `clone' D */
+		return -1;
 	}
-
-	/* `clone' D */
-	qmsg = (uintptr_t)trodi;
-	trods[trodi++] = d;
 	/* insert to heap */
 	truf_wheap_add_deferred(q, t, qmsg);
 	return 0;
 }
 
+static int
+truf_add_strm(const char *fn)
+{
+/* register trod file FN for lazy reading by co_echs_pop */
+	truf_rdr_t r;
+	FILE *f;
+
+	if (UNLIKELY((f = truf_fopen(fn)) == NULL)) {
+		return -1;
+	} else if (UNLIKELY((r = make_truf_rdr(f)) == NULL)) {
+		truf_fclose(f);
+		return -1;
+	} else if (!(nstrms % 16U)) {
+		strms = realloc(strms, (nstrms + 16U) * sizeof(*strms));
+	}
+	strms[nstrms++] = (struct trod_strm_s){fn, f, r};
+	return 0;
+}
+
+static const char*
+truf_strm_next(struct trod_strm_s *s)
+{
+/* advance S to its next directive, return NULL when exhausted */
+	const char *line;
+
+	while (truf_rdr_line(s->r, &line) > 0) {
+		char *p;
+
+		if (*line == '#') {
+			continue;
+		} else if (echs_instant_0_p(s->t = dt_strp(line, &p))) {
+			continue;
+		}
+		return s->ln = p + (*p == '\t');
+	}
+	return s->ln = NULL;
+}
+
 static void
 truf_free_trods(void)
 {
 	if (trods != NULL) {
-		free(trods);
+		free_truf_trods(trods);
 	}
 	trods = NULL;
-	ntrods = 0U;
-	trodi = 0U;
+	for (size_t i = 0U; i < nstrms; i++) {
+		if (UNLIKELY(free_truf_rdr(strms[i].r) < 0)) {
+			error("cannot read trod file `%s'",
+			      strms[i].fn ? strms[i].fn : "-");
+			rc = -1;
+		}
+		truf_fclose(strms[i].f);
+	}
+	if (strms != NULL) {
+		free(strms);
+	}
+	strms = NULL;
+	nstrms = 0U;
 	return;
 }
 
-
+
 /* coroutine for the reader of echs files, key will always be date/time
  * and value is the rest of the line */
 declcoru(co_echs_rdr, {
@@ -191,21 +263,51 @@ static const struct co_rdr_res_s {
 	const char *ln;
 	size_t lz;
 	size_t nl;
+	/* number of tabs in LN and their offsets relative to LN */
+	size_t nf;
+	uint32_t fo[TRUF_TOK_MAXF];
+	/* whether T's date part differs from the previous line's */
+	bool nd;
 } *defcoru(co_echs_rdr, ia, UNUSED(arg))
 {
-	char *line = NULL;
-	size_t llen = 0UL;
+	const char *line;
 	ssize_t nrd;
 	/* we'll yield a rdr_res */
 	struct co_rdr_res_s res = {.nl = 0U};
-	FILE *f = ia->f;
-
-	while ((nrd = getline(&line, &llen, f)) > 0) {
+	truf_rdr_t r;
+	/* last YYYY-MM-DD prefix seen and its date part */
+	char dpfx[10U];
+	echs_instant_t dmem = {.u = 0U};
+	uint32_t odp = 0U;
+
+	if (UNLIKELY((r = make_truf_rdr(ia->f)) == NULL)) {
+		return 0;
+	}
+	while ((nrd = truf_rdr_line(r, &line)) > 0) {
+		const uint32_t *tabs;
+		size_t ntabs;
+		size_t j, k;
 		char *p;
 
 		if (*line == '#') {
 			continue;
-		} else if (echs_instant_0_p(res.t = dt_strp(line, &p))) {
+		} else if (LIKELY(dmem.u) && LIKELY(nrd > 11) &&
+			   (line[10U] == 'T' || line[10U] == ' ') &&
+			   !memcmp(line, dpfx, sizeof(dpfx))) {
+			/* same day as before, just read the time */
+			res.t = dt_strp_time(dmem, line + 11U, &p);
+		} else if (!echs_instant_0_p(res.t = dt_strp(line, &p)) &&
+			   res.t.dpart != dmem.dpart) {
+			/* remember fixed-width date prefixes only */
+			dmem.u = 0U;
+			if (p - line > 10 &&
+			    line[4U] == '-' && line[7U] == '-' &&
+			    (line[10U] == 'T' || line[10U] == ' ')) {
+				memcpy(dpfx, line, sizeof(dpfx));
+				dmem.dpart = res.t.dpart;
+			}
+		}
+		if (echs_instant_0_p(res.t)) {
 			continue;
 		} else if (*p != '\t') {
 			;
@@ -213,31 +315,242 @@ static const struct co_rdr_res_s {
 			/* fast forward a bit */
 			p++;
 		}
+		res.nd = res.t.dpart != odp;
+		odp = res.t.dpart;
+		/* rebase the tokeniser's tab offsets to P */
+		tabs = truf_rdr_tabs(r, &ntabs);
+		for (j = 0U; j < ntabs && line + tabs[j] < p; j++);
+		for (k = 0U; j < ntabs; j++, k++) {
+			res.fo[k] = tabs[j] - (p - line);
+		}
 		/* pack the result structure */
 		res.ln = p;
 		res.lz = nrd - (p - line);
 		res.nl++;
+		res.nf = k;
 		yield(res);
 	}
 
-	free(line);
-	line = NULL;
-	llen = 0U;
+	if (UNLIKELY(free_truf_rdr(r) < 0)) {
+		error("cannot read input file");
+		rc = -1;
+	}
+	return 0;
+}
+
+static inline const char*
+co_rdr_fld(const struct co_rdr_res_s *ln, size_t i)
+{
+/* return the beginning of the I-th field in LN or NULL if there's none */
+	if (i == 0U) {
+		return ln->ln;
+	} else if (LIKELY(i <= ln->nf)) {
+		return ln->ln + ln->fo[i - 1U] + 1U;
+	}
+	return NULL;
+}
+
+/* steps are passed between coroutines in blocks of NSTEP_BLK
+ * to save on context switches, the block is owned by the yielding
+ * coroutine and good until the next call to it */
+#define NSTEP_BLK	(4096U)
+
+struct step_blk_s {
+	size_t n;
+	struct truf_step_s s[NSTEP_BLK];
+};
+
+static struct step_blk_s*
+make_step_blk(void)
+{
+	struct step_blk_s *res;
+
+	if (LIKELY((res = malloc(sizeof(*res))) != NULL)) {
+		res->n = 0U;
+	}
+	return res;
+}
+
+static void
+free_step_blk(struct step_blk_s *b)
+{
+	free(b);
+	return;
+}
+
+static inline truf_step_cell_t
+step_blk_next(coru_t c, const struct step_blk_s **b, size_t *i)
+{
+/* advance cursor I in block B, fetch the next block from C if need be */
+	if (LIKELY(*b != NULL) && LIKELY(++*i < (*b)->n)) {
+		return (*b)->s + *i;
+	} else if ((*b = next(c)) == NULL) {
+		return NULL;
+	}
+	*i = 0U;
+	return (*b)->s;
+}
+
+static inline void
+step_blk_push(coru_t c, struct step_blk_s *b, const struct truf_step_s *s)
+{
+/* append S to B and hand B to C when full */
+	b->s[b->n] = *s;
+	if (UNLIKELY(++b->n >= NSTEP_BLK)) {
+		____next(c, b);
+		b->n = 0U;
+	}
+	return;
+}
+
+static inline void
+step_blk_flush(coru_t c, struct step_blk_s *b)
+{
+/* hand what's left in B to C */
+	if (b->n) {
+		____next(c, b);
+		b->n = 0U;
+	}
+	return;
+}
+
+/* reorder buffer for quote lines that are slightly out of order,
+ * lines are held back in a heap until they're older than the window
+ * wrt the newest line, lines with equal stamps keep their order */
+struct reord_s {
+	truf_wheap_t q;
+	echs_idiff_t win;
+	/* newest stamp seen so far, stamp of the last released lines */
+	echs_instant_t newest;
+	echs_instant_t last;
+	/* slots of held lines, their sequence numbers and free slots */
+	struct truf_step_s *s;
+	size_t *sq;
+	uintptr_t *fr;
+	size_t ns;
+	size_t nfr;
+	size_t zs;
+	size_t nsq;
+	/* slots of the lines being released, in input order */
+	uintptr_t *grp;
+	size_t ngrp;
+	size_t igrp;
+	size_t zgrp;
+};
+
+static struct reord_s*
+make_reord(echs_idiff_t win)
+{
+	struct reord_s *res;
+
+	if (UNLIKELY((res = calloc(1, sizeof(*res))) == NULL)) {
+		return NULL;
+	} else if (UNLIKELY((res->q = make_truf_wheap()) == NULL)) {
+		free(res);
+		return NULL;
+	}
+	res->win = win;
+	return res;
+}
+
+static void
+free_reord(struct reord_s *r)
+{
+	free_truf_wheap(r->q);
+	free(r->s);
+	free(r->sq);
+	free(r->fr);
+	free(r->grp);
+	free(r);
+	return;
+}
+
+static int
+reord_add(struct reord_s *r, const struct truf_step_s *s)
+{
+/* hold S back, return -1 if S is older than what's been released */
+	uintptr_t k;
+
+	if (UNLIKELY(echs_instant_lt_p(s->t, r->last))) {
+		return -1;
+	} else if (r->nfr) {
+		k = r->fr[--r->nfr];
+	} else {
+		if (UNLIKELY(r->ns >= r->zs)) {
+			const size_t nu = r->zs ? r->zs * 2U : 256U;
+
+			r->s = realloc(r->s, nu * sizeof(*r->s));
+			r->sq = realloc(r->sq, nu * sizeof(*r->sq));
+			r->fr = realloc(r->fr, nu * sizeof(*r->fr));
+			r->zs = nu;
+		}
+		k = r->ns++;
+	}
+	r->s[k] = *s;
+	r->sq[k] = r->nsq++;
+	truf_wheap_add(r->q, s->t, k);
+	if (echs_instant_lt_p(r->newest, s->t)) {
+		r->newest = s->t;
+	}
 	return 0;
 }
 
+static bool
+reord_pop(struct reord_s *r, struct truf_step_s *tgt, bool drainp)
+{
+/* release the next line into TGT, if it's old enough or DRAINP is set */
+	if (r->igrp >= r->ngrp) {
+		const echs_instant_t t = truf_wheap_top_rank(r->q);
+
+		if (echs_instant_0_p(t)) {
+			return false;
+		} else if (!drainp &&
+			   echs_idiff_lt_p(
+				   echs_instant_diff(r->newest, t), r->win)) {
+			/* still within the window */
+			return false;
+		}
+		/* collect all lines stamped T and sort them by sequence */
+		r->ngrp = r->igrp = 0U;
+		do {
+			const uintptr_t k = truf_wheap_pop(r->q);
+			size_t j;
+
+			if (UNLIKELY(r->ngrp >= r->zgrp)) {
+				r->zgrp = r->zgrp ? r->zgrp * 2U : 16U;
+				r->grp = realloc(
+					r->grp, r->zgrp * sizeof(*r->grp));
+			}
+			for (j = r->ngrp++;
+			     j > 0U && r->sq[r->grp[j - 1U]] > r->sq[k]; j--) {
+				r->grp[j] = r->grp[j - 1U];
+			}
+			r->grp[j] = k;
+		} while (echs_instant_eq_p(truf_wheap_top_rank(r->q), t));
+		r->last = t;
+	}
+	with (const uintptr_t k = r->grp[r->igrp++]) {
+		*tgt = r->s[k];
+		r->fr[r->nfr++] = k;
+	}
+	return true;
+}
+
 /* coroutine for the reader of quote series echs files,
- * the result is specific to truffle, returning a truf_step_cell_t */
+ * the result is specific to truffle, returning blocks of steps */
 declcoru(co_tser_rdr, {
 		FILE *f;
 	}, {});
 
-static truf_step_cell_t
+static const struct step_blk_s*
 defcoru(co_tser_rdr, ia, UNUSED(arg))
 {
 	echs_instant_t olt = {.u = 0};
 	coru_t rdr;
-	/* we'll yield a truf_step object */
+	/* we'll yield blocks of truf_step objects */
+	struct step_blk_s *b;
+	/* reorder buffer, if lines may come out of order */
+	struct reord_s *ro = NULL;
 	struct truf_step_s res;
 	unsigned int flds = 0U;
 #define FLD_SYMBOL	(1U)
@@ -246,9 +559,46 @@ defcoru(co_tser_rdr, ia, UNUSED(arg))
 #define FLD_VOLUME	(8U)
 #define FLD_OPNINT	(16U)
 
+	if (UNLIKELY((b = make_step_blk()) == NULL)) {
+		rc = -1;
+		return 0;
+	} else if (truf_pack_p(ia->f)) {
+		/* lines have been decoded already, just pass them on */
+		truf_pack_t pk;
+		int r;
+
+		if (UNLIKELY((pk = make_truf_pack_rd(ia->f)) == NULL)) {
+			errno = 0, error("\
+Error: unsupported packed time series");
+			rc = -1;
+			goto fin;
+		}
+		while (!(r = truf_pack_next(pk, b->s + b->n))) {
+			if (UNLIKELY(++b->n >= NSTEP_BLK)) {
+				yield_ptr(b);
+				b->n = 0U;
+			}
+		}
+		if (UNLIKELY(r < -1)) {
+			errno = 0, error("\
+Error: packed time series is truncated or corrupt");
+			rc = -1;
+		}
+		free_truf_pack(pk);
+		goto fin;
+	}
+
 	init_coru();
 	rdr = make_coru(co_echs_rdr, ia->f);
 
+	if (!reorder_window.dd && !reorder_window.msd) {
+		/* strictly chronological */
+		;
+	} else if (UNLIKELY((ro = make_reord(reorder_window)) == NULL)) {
+		rc = -1;
+		goto bugger;
+	}
+
 	/* get a data probe */
 	const struct co_rdr_res_s *ln;
 	if ((ln = next(rdr)) == NULL) {
@@ -308,10 +658,18 @@ defcoru(co_tser_rdr, ia, UNUSED(arg))
 	}
 
 	do {
-		char *on;
+		/* field index of the first price, sizes and prices are
+		 * positional from there */
+		const size_t px = flds & FLD_SYMBOL;
+		const char *fp;
 
 		res.t = ln->t;
-		if (UNLIKELY(echs_instant_lt_p(res.t, olt))) {
+		if (UNLIKELY(ro != NULL)) {
+			/* the reorder buffer will check */
+			;
+		} else if (UNLIKELY(ln->nd
+				    ? echs_instant_lt_p(res.t, olt)
+				    : echs_instant_intra_lt_p(res.t, olt))) {
 			errno = 0, error("\
 Error: violation of chronologicity in line %zu of time series", ln->nl);
 			rc = -1;
@@ -319,79 +677,260 @@ Error: violation of chronologicity in line %zu of time series", ln->nl);
 		}
 		olt = res.t;
 		if (LIKELY(flds & FLD_SYMBOL)) {
-			res.sym = truf_sym_rd(ln->ln, &on);
-			on++;
+			res.sym = truf_sym_rd(ln->ln, NULL);
 		} else {
 			res.sym.u = 0U;
-			on = deconst(ln->ln);
 		}
 
 		/* snarf price(s) */
-		if (LIKELY(flds & (FLD_SETTLE | FLD_BIDASK))) {
-			res.bid = strtopx(on, &on);
+		if (LIKELY(flds & (FLD_SETTLE | FLD_BIDASK)) &&
+		    LIKELY((fp = co_rdr_fld(ln, px + 0U)) != NULL)) {
+			res.bid = strtopx(fp, NULL);
 		} else {
-			res.bid = res.ask = NANPX;
+			res.bid = NANPX;
 		}
 
-		if (UNLIKELY(flds & FLD_BIDASK)) {
-			on++;
-			res.ask = strtopx(on, &on);
+		if (UNLIKELY(flds & FLD_BIDASK) &&
+		    LIKELY((fp = co_rdr_fld(ln, px + 1U)) != NULL)) {
+			res.ask = strtopx(fp, NULL);
 		} else {
 			res.ask = NANPX;
-			on += *on == '\t';
 		}
 
-		if (UNLIKELY(flds & FLD_VOLUME)) {
-			on++;
-			res.vol = strtoqx(on, &on);
+		if (UNLIKELY(flds & FLD_VOLUME) &&
+		    LIKELY((fp = co_rdr_fld(ln, px + 2U)) != NULL)) {
+			res.vol = strtoqx(fp, NULL);
 		} else {
 			res.vol = NANQX;
-			on += *on == '\t';
 		}
 
-		if (UNLIKELY(flds & FLD_OPNINT)) {
-			on++;
-			res.opi = strtoqx(on, &on);
+		if (UNLIKELY(flds & FLD_OPNINT) &&
+		    LIKELY((fp = co_rdr_fld(ln, px + 3U)) != NULL)) {
+			res.opi = strtoqx(fp, NULL);
 		} else {
 			res.opi = NANQX;
 		}
 
-		yield(res);
+		if (LIKELY(ro == NULL)) {
+			b->s[b->n] = res;
+			if (UNLIKELY(++b->n >= NSTEP_BLK)) {
+				yield_ptr(b);
+				b->n = 0U;
+			}
+			continue;
+		} else if (UNLIKELY(reord_add(ro, &res) < 0)) {
+			errno = 0, error("\
+Error: violation of chronologicity in line %zu of time series \
+beyond the reorder window", ln->nl);
+			rc = -1;
+			goto bugger;
+		}
+		while (reord_pop(ro, b->s + b->n, false)) {
+			if (UNLIKELY(++b->n >= NSTEP_BLK)) {
+				yield_ptr(b);
+				b->n = 0U;
+			}
+		}
 	} while ((ln = next(rdr)) != NULL);
 
 bugger:
+	if (ro != NULL) {
+		/* release what's left */
+		while (reord_pop(ro, b->s + b->n, true)) {
+			if (UNLIKELY(++b->n >= NSTEP_BLK)) {
+				yield_ptr(b);
+				b->n = 0U;
+			}
+		}
+		free_reord(ro);
+	}
 	free_coru(rdr);
 	fini_coru();
+fin:
+	if (b->n) {
+		/* yield the rest */
+		yield_ptr(b);
+	}
+	free_step_blk(b);
 	return 0;
 }
 
 
+/* coroutine merging the steps of several quote series in chronological
+ * order, each series is read by its own co_tser_rdr */
+declcoru(co_tser_mrg, {
+		FILE *const *f;
+		size_t nf;
+	}, {});
+
+static const struct step_blk_s*
+defcoru(co_tser_mrg, ia, UNUSED(arg))
+{
+	struct {
+		coru_t rdr;
+		const struct step_blk_s *b;
+		size_t i;
+	} *src;
+	/* sources keyed by the stamp of their next step */
+	truf_wheap_t q;
+	/* we'll yield blocks of truf_step objects */
+	struct step_blk_s *b;
+
+	if (UNLIKELY((b = make_step_blk()) == NULL)) {
+		rc = -1;
+		return 0;
+	} else if (UNLIKELY((src = calloc(ia->nf, sizeof(*src))) == NULL)) {
+		rc = -1;
+		goto fin;
+	} else if (UNLIKELY((q = make_truf_wheap()) == NULL)) {
+		rc = -1;
+		free(src);
+		goto fin;
+	}
+
+	init_coru();
+	for (size_t i = 0U; i < ia->nf; i++) {
+		truf_step_cell_t s;
+
+		src[i].rdr = make_coru(co_tser_rdr, ia->f[i]);
+		s = step_blk_next(src[i].rdr, &src[i].b, &src[i].i);
+		if (s != NULL) {
+			truf_wheap_add(q, s->t, i);
+		}
+	}
+
+	while (!echs_instant_0_p(truf_wheap_top_rank(q))) {
+		const uintptr_t i = truf_wheap_pop(q);
+		/* stamp of the next source in line, 0 if there's none */
+		const echs_instant_t t = truf_wheap_top_rank(q);
+		truf_step_cell_t s = src[i].b->s + src[i].i;
+
+		/* copy a whole run of source I up to T,
+		 * the heap is only consulted between runs */
+		do {
+			b->s[b->n] = *s;
+			if (UNLIKELY(++b->n >= NSTEP_BLK)) {
+				yield_ptr(b);
+				b->n = 0U;
+			}
+		} while ((s = step_blk_next(
+				  src[i].rdr, &src[i].b, &src[i].i)) != NULL &&
+			 (echs_instant_0_p(t) || echs_instant_le_p(s->t, t)));
+		if (s != NULL) {
+			truf_wheap_add(q, s->t, i);
+		}
+	}
+
+	for (size_t i = 0U; i < ia->nf; i++) {
+		free_coru(src[i].rdr);
+	}
+	fini_coru();
+	free_truf_wheap(q);
+	free(src);
+fin:
+	if (b->n) {
+		/* yield the rest */
+		yield_ptr(b);
+	}
+	free_step_blk(b);
+	return 0;
+}
+
 declcoru(co_echs_pop, {
 		truf_wheap_t q;
 	}, {});
 
-static truf_step_cell_t
+static const struct step_blk_s*
 defcoru(co_echs_pop, ia, UNUSED(arg))
 {
-/* coroutine for the wheap popper */
-	/* we'll yield a pop_res */
-	struct truf_step_s res = {
-		.old = NANEX,
-	};
+/* coroutine for the wheap popper, yields blocks of steps that share
+ * one time stamp, all directives of a stamp at once unless there's
+ * more than fit in a block */
 	truf_wheap_t q = ia->q;
+	struct step_blk_s *b;
+	/* trods indices of the directives just popped */
+	uintptr_t *d;
 
-	while (!echs_instant_0_p(res.t = truf_wheap_top_rank(q))) {
-		/* assume it's a truf_trod_t */
-		uintptr_t tmp = truf_wheap_pop(q);
-		res.sym = trods[tmp].sym[0U];
-		res.new = trods[tmp].exp;
-		yield(res);
-		if (trods[tmp].sym[1U].u) {
-			res.sym = trods[tmp].sym[1U];
-			res.new = UNITEX;
-			yield(res);
+	if (UNLIKELY((b = make_step_blk()) == NULL)) {
+		rc = -1;
+		return 0;
+	} else if (UNLIKELY((d = calloc(NSTEP_BLK / 2U, sizeof(*d))) == NULL)) {
+		rc = -1;
+		goto out;
+	}
+
+	/* prime the lazily read trod files */
+	for (size_t i = 0U; i < nstrms; i++) {
+		truf_strm_next(strms + i);
+	}
+
+	for (;;) {
+		echs_instant_t t = truf_wheap_top_rank(q);
+		size_t nadd = 0U;
+		size_t nd;
+
+		/* top up the heap with directives from the streams that
+		 * come before or at the heap's current top */
+		for (size_t i = 0U; i < nstrms; i++) {
+			if (strms[i].ln != NULL &&
+			    (echs_instant_0_p(t) ||
+			     echs_instant_lt_p(strms[i].t, t))) {
+				t = strms[i].t;
+			}
+		}
+		for (size_t i = 0U; i < nstrms; i++) {
+			struct trod_strm_s *s = strms + i;
+
+			while (s->ln != NULL && echs_instant_le_p(s->t, t)) {
+				const echs_instant_t st = s->t;
+
+				truf_add_trod(q, st, truf_trod_rd(s->ln, NULL));
+				nadd++;
+				if (truf_strm_next(s) != NULL &&
+				    UNLIKELY(echs_instant_lt_p(s->t, st))) {
+					errno = 0, error("\
+Error: trod file `%s' is not sorted", s->fn ? s->fn : "-");
+					rc = -1;
+					goto out;
+				}
+			}
 		}
+		if (nadd) {
+			truf_wheap_fix_deferred(q);
+		}
+
+		if (echs_instant_0_p(t)) {
+			break;
+		}
+		/* assume they're truf_trod_t's */
+		nd = truf_wheap_pop_equal_range(q, d, NSTEP_BLK / 2U);
+		b->n = 0U;
+		for (size_t i = 0U; i < nd; i++) {
+			const truf_trod_t *c = truf_trods_get(trods, d[i]);
+
+			b->s[b->n++] = (struct truf_step_s){
+				.t = t,
+				.sym = c->sym[0U],
+				.new = c->exp,
+				.old = NANEX,
+			};
+			if (c->sym[1U].u) {
+				b->s[b->n++] = (struct truf_step_s){
+					.t = t,
+					.sym = c->sym[1U],
+					.new = UNITEX,
+					.old = NANEX,
+				};
+			}
+			if (nstrms) {
+				truf_trods_rel(trods, d[i]);
+			}
+		}
+		yield_ptr(b);
 	}
+out:
+	free(d);
+	free_step_blk(b);
 	return 0;
 }
 
@@ -407,7 +946,7 @@ defcoru(co_inst_rdr, ia, UNUSED(arg))
 	const char *const *dt = ia->dt;
 	const char *const *const edt = ia->dt + ia->ndt;
 	/* we'll yield a rdr_res */
-	struct co_rdr_res_s res;
+	struct co_rdr_res_s res = {.nf = 0U};
 
 	for (; dt < edt; dt++) {
 		char *on;
@@ -420,7 +959,7 @@ defcoru(co_inst_rdr, ia, UNUSED(arg))
 }
 
 declcoru(co_echs_out, {
-		FILE *f;
+		truf_wrr_t w;
 		unsigned int relp:1U;
 		unsigned int absp:1U;
 		unsigned int ocop:1U;
@@ -429,56 +968,59 @@ declcoru(co_echs_out, {
 	}, {});
 
 static const void*
-_defcoru(co_echs_out, iap, truf_step_cell_t arg)
+_defcoru(co_echs_out, iap, const struct step_blk_s *arg)
 {
-	char buf[256U];
-	const char *const ep = buf + sizeof(buf);
 	coru_initargs(co_echs_out) ia = *iap;
 
 	while (arg != NULL) {
-		char *bp = buf;
-		echs_instant_t t = arg->t;
-		truf_sym_t sym = arg->sym;
-
-		bp += dt_strf(bp, ep - bp, t);
-		if (LIKELY(sym.u)) {
-			/* convert mmys */
-			if (truf_mmy_p(sym)) {
-				if (ia.ocop) {
+		for (size_t i = 0U; i < arg->n; i++) {
+			const struct truf_step_s *e = arg->s + i;
+			char *const buf = truf_wrr_buf(ia.w);
+			const char *const ep = buf + TRUF_WRR_MAXLN;
+			char *bp = buf;
+			echs_instant_t t = e->t;
+			truf_sym_t sym = e->sym;
+
+			bp += dt_strf(bp, ep - bp, t);
+			if (LIKELY(sym.u)) {
+				/* convert mmys */
+				if (!truf_mmy_p(sym)) {
+					/* transform not */
+					;
+				} else if (ia.ocop) {
 					sym.mmy = truf_mmy_oco(sym.mmy, t.y);
 				} else if (ia.absp) {
 					sym.mmy = truf_mmy_abs(sym.mmy, t.y);
 				} else if (ia.relp) {
 					sym.mmy = truf_mmy_rel(sym.mmy, t.y);
 				}
-			}
-			*bp++ = '\t';
-			bp += truf_sym_wr(bp, ep - bp, sym);
-		}
-		if (ia.prnt_prcp) {
-			if (!isnanpx(arg->bid)) {
 				*bp++ = '\t';
-				bp += pxtostr(bp, ep - bp, arg->bid);
+				bp += truf_sym_wr(bp, ep - bp, sym);
 			}
-			if (!isnanpx(arg->ask)) {
-				*bp++ = '\t';
-				bp += pxtostr(bp, ep - bp, arg->ask);
-			}
-		}
-		if (ia.prnt_expp) {
-			*bp++ = '\t';
-			if (!isnanpx(arg->old)) {
-				bp += extostr(bp, ep - bp, arg->old);
-				*bp++ = '-';
-				*bp++ = '>';
+			if (ia.prnt_prcp) {
+				if (!isnanpx(e->bid)) {
+					*bp++ = '\t';
+					bp += pxtostr(bp, ep - bp, e->bid);
+				}
+				if (!isnanpx(e->ask)) {
+					*bp++ = '\t';
+					bp += pxtostr(bp, ep - bp, e->ask);
+				}
 			}
-			if (!isnanpx(arg->new)) {
-				bp += extostr(bp, ep - bp, arg->new);
+			if (ia.prnt_expp) {
+				*bp++ = '\t';
+				if (!isnanpx(e->old)) {
+					bp += extostr(bp, ep - bp, e->old);
+					*bp++ = '-';
+					*bp++ = '>';
+				}
+				if (!isnanpx(e->new)) {
+					bp += extostr(bp, ep - bp, e->new);
+				}
 			}
+			*bp++ = '\n';
+			truf_wrr_adv(ia.w, bp - buf);
 		}
-		*bp++ = '\n';
-		*bp = '\0';
-		fputs(buf, ia.f);
 
 		arg = yield_ptr(NULL);
 	}
@@ -486,7 +1028,7 @@ _defcoru(co_echs_out, iap, truf_step_cell_t arg)
 }
 
 declcoru(co_roll_out, {
-		FILE *f;
+		truf_wrr_t w;
 		bool absp;
 		signed int prec;
 	}, {
@@ -496,48 +1038,59 @@ declcoru(co_roll_out, {
 		truf_quant_t opi;
 	});
 
+/* co_roll_out takes its arguments in blocks too */
+struct roll_blk_s {
+	size_t n;
+	coru_args(co_roll_out) r[NSTEP_BLK];
+};
+
 static const void*
-defcoru(co_roll_out, iap, arg)
+_defcoru(co_roll_out, iap, const struct roll_blk_s *arg)
 {
-	char buf[256U];
-	const char *const ep = buf + sizeof(buf);
 	coru_initargs(co_roll_out) ia = *iap;
 
 	if (!ia.absp) {
 		/* non-abs precision mode */
 		while (arg != NULL) {
-			char *bp = buf;
-			truf_price_t prc;
+			for (size_t i = 0U; i < arg->n; i++) {
+				const coru_args(co_roll_out) *r = arg->r + i;
+				char *const buf = truf_wrr_buf(ia.w);
+				const char *const ep = buf + TRUF_WRR_MAXLN;
+				char *bp = buf;
+				truf_price_t prc;
+
+				if (UNLIKELY(isnanpx(prc = r->prc))) {
+					/* refuse to print nans */
+					continue;
+				}
 
-			if (UNLIKELY(isnanpx(prc = arg->prc))) {
-				/* refuse to print nans */
-				goto nex2;
-			}
+				/* print time stamp */
+				bp += dt_strf(bp, ep - bp, r->t);
+				*bp++ = '\t';
 
-			/* print time stamp */
-			bp += dt_strf(bp, ep - bp, arg->t);
-			*bp++ = '\t';
+				/* scale to precision */
+				if (UNLIKELY(ia.prec)) {
+					/* come up with a new raw value */
+					int tgtx = quantexpd(prc) + ia.prec;
+					truf_price_t scal;
 
-			/* scale to precision */
-			if (UNLIKELY(ia.prec)) {
-				/* come up with a new raw value */
-				int tgtx = quantexpd(prc) + ia.prec;
-				truf_price_t scal = scalbnd(ZEROPX, tgtx);
-				prc = quantized(prc, scal);
-			}
-			bp += pxtostr(bp, ep - bp, prc);
-			if (!isnanqx(arg->vol)) {
-				*bp++ = '\t';
-				bp += qxtostr(bp, ep - bp, arg->vol);
-				if (!isnanqx(arg->opi)) {
+					scal = scalbnd(ZEROPX, tgtx);
+					prc = quantized(prc, scal);
+				}
+				bp += pxtostr(bp, ep - bp, prc);
+				if (!isnanqx(r->vol)) {
 					*bp++ = '\t';
-					bp += qxtostr(bp, ep - bp, arg->opi);
+					bp += qxtostr(bp, ep - bp, r->vol);
+					if (!isnanqx(r->opi)) {
+						*bp++ = '\t';
+						bp += qxtostr(
+							bp, ep - bp, r->opi);
+					}
 				}
+				*bp++ = '\n';
+				truf_wrr_adv(ia.w, bp - buf);
 			}
-			*bp++ = '\n';
-			*bp = '\0';
-			fputs(buf, ia.f);
-		nex2:
+
 			arg = yield_ptr(NULL);
 		}
 	} else /*if (absp)*/ {
@@ -546,40 +1099,158 @@ defcoru(co_roll_out, iap, arg)
 
 		/* absolute precision mode */
 		while (arg != NULL) {
-			char *bp = buf;
-			truf_price_t prc;
+			for (size_t i = 0U; i < arg->n; i++) {
+				const coru_args(co_roll_out) *r = arg->r + i;
+				char *const buf = truf_wrr_buf(ia.w);
+				const char *const ep = buf + TRUF_WRR_MAXLN;
+				char *bp = buf;
+				truf_price_t prc;
+
+				if (UNLIKELY(isnanpx(prc = r->prc))) {
+					/* refuse to print nans */
+					continue;
+				}
+				/* print time stamp */
+				bp += dt_strf(bp, ep - bp, r->t);
+				*bp++ = '\t';
 
-			if (UNLIKELY(isnanpx(prc = arg->prc))) {
-				/* refuse to print nans */
-				goto nex4;
+				/* scale to precision */
+				prc = quantized(prc, scal);
+				bp += pxtostr(bp, ep - bp, prc);
+				*bp++ = '\n';
+				truf_wrr_adv(ia.w, bp - buf);
 			}
-			/* print time stamp */
-			bp += dt_strf(bp, ep - bp, arg->t);
-			*bp++ = '\t';
 
-			/* scale to precision */
-			prc = quantized(prc, scal);
-			bp += pxtostr(bp, ep - bp, prc);
-			*bp++ = '\n';
-			*bp = '\0';
-			fputs(buf, ia.f);
-		nex4:
 			arg = yield_ptr(NULL);
 		}
 	}
 	return 0;
 }
 
+declcoru(co_echs_bin, {
+		truf_wrr_t w;
+		unsigned int relp:1U;
+		unsigned int absp:1U;
+		unsigned int ocop:1U;
+	}, {});
+
+static const void*
+_defcoru(co_echs_bin, iap, const struct step_blk_s *arg)
+{
+/* like co_echs_out but writing struct truf_bin_step_s records,
+ * the caller writes the header so there's one even without records */
+	coru_initargs(co_echs_bin) ia = *iap;
+	bool warnp = false;
+
+	while (arg != NULL) {
+		for (size_t i = 0U; i < arg->n; i++) {
+			const struct truf_step_s *e = arg->s + i;
+			struct truf_bin_step_s r = {
+				.t = e->t.u,
+				.bid = e->bid,
+				.ask = e->ask,
+				.old = e->old,
+				.new = e->new,
+			};
+			truf_sym_t sym = e->sym;
+
+			if (LIKELY(sym.u)) {
+				char buf[256U];
+				size_t z;
+
+				/* convert mmys */
+				if (!truf_mmy_p(sym)) {
+					/* transform not */
+					;
+				} else if (ia.ocop) {
+					sym.mmy = truf_mmy_oco(sym.mmy, e->t.y);
+				} else if (ia.absp) {
+					sym.mmy = truf_mmy_abs(sym.mmy, e->t.y);
+				} else if (ia.relp) {
+					sym.mmy = truf_mmy_rel(sym.mmy, e->t.y);
+				}
+				z = truf_sym_wr(buf, sizeof(buf), sym);
+				if (LIKELY(z <= sizeof(r.sym))) {
+					/* fits */
+					;
+				} else if (z = sizeof(r.sym), !warnp) {
+					errno = 0, error("\
+Warning: symbols longer than %zu characters are truncated", z);
+					warnp = true;
+				}
+				memcpy(r.sym, buf, z);
+			}
+			memcpy(truf_wrr_buf(ia.w), &r, sizeof(r));
+			truf_wrr_adv(ia.w, sizeof(r));
+		}
+
+		arg = yield_ptr(NULL);
+	}
+	return 0;
+}
+
+declcoru(co_roll_bin, {
+		truf_wrr_t w;
+		bool absp;
+		signed int prec;
+	}, {});
+
+static const void*
+_defcoru(co_roll_bin, iap, const struct roll_blk_s *arg)
+{
+/* like co_roll_out but writing struct truf_bin_roll_s records,
+ * the header is the caller's business, see co_echs_bin() */
+	coru_initargs(co_roll_bin) ia = *iap;
+	/* absolute precision mode wants -ia.prec fractional digits */
+	const truf_price_t scal = scalbnd(UNITPX, ia.prec);
+
+	while (arg != NULL) {
+		for (size_t i = 0U; i < arg->n; i++) {
+			const coru_args(co_roll_out) *r = arg->r + i;
+			struct truf_bin_roll_s b = {
+				.t = r->t.u,
+				.vol = ia.absp ? NANQX : r->vol,
+				.opi = ia.absp || isnanqx(r->vol)
+				? NANQX : r->opi,
+			};
+			truf_price_t prc;
+
+			if (UNLIKELY(isnanpx(prc = r->prc))) {
+				/* refuse to write nans */
+				continue;
+			} else if (ia.absp) {
+				prc = quantized(prc, scal);
+			} else if (UNLIKELY(ia.prec)) {
+				/* come up with a new raw value */
+				int tgtx = quantexpd(prc) + ia.prec;
+
+				prc = quantized(prc, scalbnd(ZEROPX, tgtx));
+			}
+			b.prc = prc;
+			memcpy(truf_wrr_buf(ia.w), &b, sizeof(b));
+			truf_wrr_adv(ia.w, sizeof(b));
+		}
+
+		arg = yield_ptr(NULL);
+	}
+	return 0;
+}
+
 declcoru(co_tser_flt, {
 		truf_wheap_t q;
-		FILE *tser;
+		/* time series files, merged if there's more than one */
+		FILE *const *tser;
+		size_t ntser;
 		/* max quote age */
 		echs_idiff_t mqa;
+		/* only consider quotes within FROM and TILL */
+		echs_instant_t from;
+		echs_instant_t till;
 		unsigned int edgp:1U;
 		unsigned int levp:1U;
 	}, {});
 
-static truf_step_cell_t
+static const struct step_blk_s*
 defcoru(co_tser_flt, iap, UNUSED(arg))
 {
 /* yields a co_edg_res when exposure changes
@@ -598,22 +1269,63 @@ defcoru(co_tser_flt, iap, UNUSED(arg))
 	coru_t pop;
 	coru_initargs(co_tser_flt) ia = *iap;
 	struct truf_step_s res;
+	/* the block we yield and the one we're reading from */
+	struct step_blk_s *b;
+	const struct step_blk_s *qb = NULL;
+	size_t qi = 0U;
+	/* the block of trod directives we're reading from */
+	const struct step_blk_s *eb = NULL;
+	size_t ei = 0U;
+
+	if (UNLIKELY((b = make_step_blk()) == NULL)) {
+		rc = -1;
+		return 0;
+	}
 
 	init_coru();
-	rdr = make_coru(co_tser_rdr, ia.tser);
+	if (LIKELY(ia.ntser == 1U)) {
+		rdr = make_coru(co_tser_rdr, *ia.tser);
+	} else {
+		rdr = make_coru(co_tser_mrg, ia.tser, ia.ntser);
+	}
 	pop = make_coru(co_echs_pop, ia.q);
 
 	truf_step_cell_t ev;
 	truf_step_cell_t qu;
-	for (qu = next(rdr), ev = next(pop); qu != NULL;) {
+
+	/* fast-forward to FROM, trod directives before it just set up
+	 * the exposures, it's as though they've been there all along */
+	for (ev = step_blk_next(pop, &eb, &ei);
+	     LIKELY(ev != NULL) && echs_instant_lt_p(ev->t, ia.from);
+	     ev = step_blk_next(pop, &eb, &ei)) {
+		truf_sym_t sym = ev->sym;
+
+		if (!truf_mmy_p(sym)) {
+			/* transform not */
+			;
+		} else if (!truf_mmy_abs_p(sym.mmy)) {
+			sym.mmy = truf_mmy_abs(sym.mmy, ev->t.y);
+		}
+		with (truf_step_t st = truf_step_find(sym)) {
+			/* no edge when the window opens */
+			st->old = st->new = ev->new;
+		}
+	}
+	do {
+		qu = step_blk_next(rdr, &qb, &qi);
+	} while (qu != NULL && echs_instant_lt_p(qu->t, ia.from));
+
+	while (qu != NULL && LIKELY(echs_instant_le_p(qu->t, ia.till))) {
 		size_t nemit = 0U;
 		size_t ndfrd = 0U;
+		/* stamp of the next directive, or the end of time */
+		echs_instant_t evt;
 
 		/* aggregate trod directives between price lines */
 		for (;
 		     LIKELY(ev != NULL) &&
 			     UNLIKELY(echs_instant_ge_p(qu->t, ev->t));
-		     ev = next(pop)) {
+		     ev = step_blk_next(pop, &eb, &ei)) {
 			truf_sym_t sym = ev->sym;
 			truf_step_t st;
 
@@ -656,6 +1368,7 @@ defcoru(co_tser_flt, iap, UNUSED(arg))
 			}
 		}
 
+		evt = LIKELY(ev != NULL) ? ev->t : (echs_instant_t){.u = -1ULL};
 		/* yield time series lines in between trod edges */
 		do {
 			truf_sym_t sym = qu->sym;
@@ -687,7 +1400,11 @@ defcoru(co_tser_flt, iap, UNUSED(arg))
 					/* update exposure */
 					ref->old = ref->new;
 				}
-				yield(res);
+				b->s[b->n] = res;
+				if (UNLIKELY(++b->n >= NSTEP_BLK)) {
+					yield_ptr(b);
+					b->n = 0U;
+				}
 			}
 
 			/* snarf symbol, always abs(?) */
@@ -722,10 +1439,14 @@ defcoru(co_tser_flt, iap, UNUSED(arg))
 			res = *st;
 			/* update exposures */
 			st->old = st->new;
-			yield(res);
-		} while (LIKELY((qu = next(rdr)) != NULL) &&
-			 (UNLIKELY(ev == NULL) ||
-			  LIKELY(echs_instant_lt_p(qu->t, ev->t))));
+			b->s[b->n] = res;
+			if (UNLIKELY(++b->n >= NSTEP_BLK)) {
+				yield_ptr(b);
+				b->n = 0U;
+			}
+		} while (LIKELY((qu = step_blk_next(rdr, &qb, &qi)) != NULL) &&
+			 LIKELY(echs_instant_le_p(qu->t, ia.till)) &&
+			 LIKELY(echs_instant_lt_p(qu->t, evt)));
 	}
 
 	if (UNLIKELY(_dfrd != dfrd)) {
@@ -737,6 +1458,12 @@ defcoru(co_tser_flt, iap, UNUSED(arg))
 	free_coru(rdr);
 	free_coru(pop);
 	fini_coru();
+
+	if (b->n) {
+		/* yield the rest */
+		yield_ptr(b);
+	}
+	free_step_blk(b);
 	return 0;
 }
 
@@ -765,12 +1492,14 @@ defcoru(co_echs_pos, ia, UNUSED(arg))
 
 	truf_step_cell_t ev;
 	const struct co_rdr_res_s *ln;
-	for (ln = next(rdr), ev = next(pop); ln != NULL;) {
+	const struct step_blk_s *eb = NULL;
+	size_t ei = 0U;
+	for (ln = next(rdr), ev = step_blk_next(pop, &eb, &ei); ln != NULL;) {
 		/* in between date/times from the RDR find trods */
 		for (;
 		     LIKELY(ev != NULL) &&
 			     UNLIKELY(!echs_instant_lt_p(ln->t, ev->t));
-		     ev = next(pop)) {
+		     ev = step_blk_next(pop, &eb, &ei)) {
 			truf_sym_t sym = ev->sym;
 			truf_step_t st;
 
@@ -819,12 +1548,39 @@ static int
 truf_read_trod_file(truf_wheap_t q, const char *fn)
 {
 /* wants a const char *fn */
+	const bool cachep = trod_cache && fn != NULL && strcmp(fn, "-");
+	/* stamps and directives read, for the cache */
+	echs_instant_t *ts = NULL;
+	truf_trod_t *ds = NULL;
+	size_t nts = 0U;
+	size_t zts = 0U;
 	coru_t rdr;
 	FILE *f;
+	int res;
+
+	if (trod_strm) {
+		/* co_echs_pop will read this one as it goes */
+		return truf_add_strm(fn);
+	} else if (!cachep) {
+		/* no caching */
+		;
+	} else with (truf_tcache_t c = truf_tcache_open(fn)) {
+		if (c == NULL) {
+			/* no cache or stale, we'll write a new one below */
+			break;
+		}
+		for (size_t i = 0U, n = truf_tcache_ntrods(c); i < n; i++) {
+			echs_instant_t t;
+			truf_trod_t d = truf_tcache_trod(c, i, &t);
+
+			truf_add_trod(q, t, d);
+		}
+		truf_tcache_close(c);
+		truf_wheap_fix_deferred(q);
+		return 0;
+	}
 
-	if (fn == NULL) {
-		f = stdin;
-	} else if (UNLIKELY((f = fopen(fn, "r")) == NULL)) {
+	if (UNLIKELY((f = truf_fopen(fn)) == NULL)) {
 		return -1;
 	}
 
@@ -837,13 +1593,182 @@ truf_read_trod_file(truf_wheap_t q, const char *fn)
 
 		/* ... and add it */
 		truf_add_trod(q, ln->t, c);
+
+		if (!cachep) {
+			continue;
+		} else if (UNLIKELY(nts >= zts)) {
+			zts = zts ? 2U * zts : 1024U;
+			ts = realloc(ts, zts * sizeof(*ts));
+			ds = realloc(ds, zts * sizeof(*ds));
+		}
+		ts[nts] = ln->t;
+		ds[nts] = c;
+		nts++;
 	}
 	/* now sort the guy */
 	truf_wheap_fix_deferred(q);
 
 	free_coru(rdr);
 	fini_coru();
-	fclose(f);
+	res = truf_fclose(f);
+
+	if (ts != NULL && res >= 0 &&
+	    truf_tcache_wr(fn, ts, ds, nts) < 0) {
+		errno = 0, error("\
+Warning: cannot write trod cache for `%s'", fn);
+	}
+	free(ts);
+	free(ds);
+	return res;
+}
+
+/* time series files as used by filter, glue and roll */
+struct tsers_s {
+	size_t n;
+	const char **fn;
+	FILE **f;
+};
+
+static int
+close_tsers(struct tsers_s *ts)
+{
+	int res = 0;
+
+	for (size_t i = 0U; i < ts->n; i++) {
+		if (UNLIKELY(truf_fclose(ts->f[i]) < 0)) {
+			error("cannot read time series file `%s'", ts->fn[i]);
+			res = -1;
+		}
+	}
+	free(ts->fn);
+	free(ts->f);
+	*ts = (struct tsers_s){0U};
+	return res;
+}
+
+static int
+open_tsers(
+	struct tsers_s *ts, const char *fn, char *const *mrg, size_t nmrg,
+	bool trodin)
+{
+/* open FN and the NMRG files in MRG, TRODIN is set if stdin is used
+ * for trods already */
+	size_t nin = trodin;
+
+#if !defined USE_ASM_CORUS
+	/* our fallback coroutines are one instance per call site */
+	if (nmrg) {
+		errno = 0, error("\
+Error: merging time series is not supported in this build");
+		return -1;
+	}
+#endif	/* !USE_ASM_CORUS */
+	*ts = (struct tsers_s){0U};
+	ts->fn = malloc((nmrg + 1U) * sizeof(*ts->fn));
+	ts->f = malloc((nmrg + 1U) * sizeof(*ts->f));
+	if (UNLIKELY(ts->fn == NULL || ts->f == NULL)) {
+		goto clo;
+	}
+	ts->fn[0U] = fn;
+	for (size_t i = 0U; i < nmrg; i++) {
+		ts->fn[i + 1U] = mrg[i];
+	}
+	for (size_t i = 0U; i <= nmrg; i++, ts->n++) {
+		const char *tfn = ts->fn[i];
+
+		if (tfn[0U] == '-' && tfn[1U] == '\0' && nin++) {
+			errno = 0, error("\
+Error: stdin can only be read once");
+			goto clo;
+		} else if (UNLIKELY((ts->f[i] = truf_fopen(tfn)) == NULL)) {
+			error("cannot open time series file `%s'", tfn);
+			goto clo;
+		}
+	}
+	return 0;
+
+clo:
+	(void)close_tsers(ts);
+	return -1;
+}
+
+static char*
+idx_fn(const char *fn)
+{
+/* return the name of FN's index file, to be freed by the caller */
+	const size_t fz = strlen(fn);
+	char *res;
+
+	if (LIKELY((res = malloc(fz + sizeof(".idx"))) != NULL)) {
+		memcpy(res, fn, fz);
+		memcpy(res + fz, ".idx", sizeof(".idx"));
+	}
+	return res;
+}
+
+static void
+seek_tsers(struct tsers_s *ts, echs_instant_t from)
+{
+/* fast-forward the files in TS to shortly before FROM using their
+ * indices, files without (usable) index are read from the start */
+	if (reorder_window.dd || reorder_window.msd) {
+		/* lines before an index entry may be younger than it */
+		return;
+	}
+	for (size_t i = 0U; i < ts->n; i++) {
+		const char *fn = ts->fn[i];
+		struct stat st, ist;
+		char *ifn;
+		FILE *idx;
+		off_t o;
+
+		if (fn[0U] == '-' && fn[1U] == '\0') {
+			/* can't seek in stdin */
+			continue;
+		} else if (UNLIKELY((ifn = idx_fn(fn)) == NULL)) {
+			continue;
+		} else if ((idx = fopen(ifn, "r")) == NULL) {
+			/* no index, no seeking */
+			free(ifn);
+			continue;
+		} else if (fstat(fileno(ts->f[i]), &st) < 0 ||
+			   fstat(fileno(idx), &ist) < 0 ||
+			   !S_ISREG(st.st_mode) || truf_pack_p(ts->f[i])) {
+			/* compressed files, packed files and things */
+			;
+		} else if (ist.st_mtime < st.st_mtime) {
+			errno = 0, error("\
+Warning: index `%s' is older than its time series, ignoring", ifn);
+		} else if ((o = truf_idx_find(idx, from)) > 0) {
+			(void)fseeko(ts->f[i], o, SEEK_SET);
+		}
+		fclose(idx);
+		free(ifn);
+	}
+	return;
+}
+
+static int
+rd_from_till(echs_instant_t ft[static 2U], const char *from, const char *till)
+{
+/* read --from and --till stamps into FT, date-only stamps span the
+ * whole day, i.e. from the start of FROM till the end of TILL */
+	ft[0U] = (echs_instant_t){.u = 0U};
+	ft[1U] = (echs_instant_t){.u = UINT64_MAX};
+	if (from == NULL) {
+		;
+	} else if (echs_instant_0_p(ft[0U] = dt_strp(from, NULL))) {
+		errno = 0, error("Error: cannot read --from stamp `%s'", from);
+		return -1;
+	} else if (echs_instant_all_day_p(ft[0U])) {
+		ft[0U].H = ft[0U].M = ft[0U].S = ft[0U].ms = 0U;
+	}
+	if (till == NULL) {
+		;
+	} else if (echs_instant_0_p(ft[1U] = dt_strp(till, NULL))) {
+		errno = 0, error("Error: cannot read --till stamp `%s'", till);
+		return -1;
+	}
 	return 0;
 }
 
@@ -1000,20 +1925,31 @@ cmd_print(const struct yuck_cmd_print_s argi[static 1U])
 		coru_t pop;
 		coru_t out;
 
+		struct step_blk_s *b;
+
+		if (UNLIKELY((b = make_step_blk()) == NULL)) {
+			rc = -1;
+			goto out;
+		}
+
 		init_coru();
 		pop = make_coru(co_echs_pop, q);
 		out = make_coru(
-			co_echs_out, stdout,
+			co_echs_out, wrr,
 			argi->rel_flag, argi->abs_flag, argi->oco_flag,
 			.prnt_expp = true);
 
-		for (truf_step_cell_t e; (e = next(pop)) != NULL;) {
-			____next(out, e);
+		for (const struct step_blk_s *pb; (pb = next(pop)) != NULL;) {
+			for (size_t i = 0U; i < pb->n; i++) {
+				step_blk_push(out, b, pb->s + i);
+			}
 		}
+		step_blk_flush(out, b);
 
 		free_coru(pop);
 		free_coru(out);
 		fini_coru();
+		free_step_blk(b);
 	}
 
 out:
@@ -1041,14 +1977,16 @@ cmd_migrate(const struct yuck_cmd_migrate_s argi[static 1U])
 		echs_instant_t i = dt_strp(argi->from_arg, NULL);
 		from = instant_to_daisy(i);
 	} else {
-		echs_instant_t i = {2000U, 1U, 1U, ECHS_ALL_DAY};
+		echs_instant_t i = {
+			.y = 2000U, .m = 1U, .d = 1U, .H = ECHS_ALL_DAY};
 		from = instant_to_daisy(i);
 	}
 	if (argi->till_arg) {
 		echs_instant_t i = dt_strp(argi->till_arg, NULL);
 		till = instant_to_daisy(i);
 	} else {
-		echs_instant_t i = {2037U, 12U, 31U, ECHS_ALL_DAY};
+		echs_instant_t i = {
+			.y = 2037U, .m = 12U, .d = 31U, .H = ECHS_ALL_DAY};
 		till = instant_to_daisy(i);
 	}
 	if (argi->lax_arg) {
@@ -1078,20 +2016,31 @@ cmd_migrate(const struct yuck_cmd_migrate_s argi[static 1U])
 		coru_t pop;
 		coru_t out;
 
+		struct step_blk_s *b;
+
+		if (UNLIKELY((b = make_step_blk()) == NULL)) {
+			rc = -1;
+			goto out;
+		}
+
 		init_coru();
 		pop = make_coru(co_echs_pop, q);
 		out = make_coru(
-			co_echs_out, stdout,
+			co_echs_out, wrr,
 			argi->rel_flag, argi->abs_flag, argi->oco_flag,
 			.prnt_expp = true);
 
-		for (truf_step_cell_t e; (e = next(pop)) != NULL;) {
-			____next(out, e);
+		for (const struct step_blk_s *pb; (pb = next(pop)) != NULL;) {
+			for (size_t i = 0U; i < pb->n; i++) {
+				step_blk_push(out, b, pb->s + i);
+			}
 		}
+		step_blk_flush(out, b);
 
 		free_coru(pop);
 		free_coru(out);
 		fini_coru();
+		free_step_blk(b);
 	}
 
 out:
@@ -1106,11 +2055,17 @@ static int
 cmd_filter(const struct yuck_cmd_filter_s argi[static 1U])
 {
 	echs_idiff_t max_quote_age;
+	struct tsers_s ts = {0U};
+	echs_instant_t ft[2U];
 	truf_wheap_t q;
 
 	if (argi->nargs < 1U) {
 		yuck_auto_usage((const yuck_t*)argi);
 		return 1;
+	} else if (argi->binary_flag && isatty(STDOUT_FILENO)) {
+		errno = 0, error("\
+Error: refusing to write binary data to a terminal");
+		return 1;
 	} else if (UNLIKELY((q = make_truf_wheap()) == NULL)) {
 		rc = -1;
 		goto out;
@@ -1122,6 +2077,19 @@ cmd_filter(const struct yuck_cmd_filter_s argi[static 1U])
 		max_quote_age = (echs_idiff_t){4095};
 	}
 
+	if (UNLIKELY(rd_from_till(ft, argi->from_arg, argi->till_arg) < 0)) {
+		rc = -1;
+		goto out;
+	} else if (UNLIKELY(open_tsers(
+				    &ts, *argi->args,
+				    argi->merge_args, argi->merge_nargs,
+				    argi->nargs <= 1U) < 0)) {
+		rc = -1;
+		goto out;
+	} else if (argi->from_arg) {
+		seek_tsers(&ts, ft[0U]);
+	}
+
 	for (size_t i = 1U; i < argi->nargs + (argi->nargs <= 1U); i++) {
 		const char *fn = argi->args[i];
 
@@ -1132,41 +2100,56 @@ cmd_filter(const struct yuck_cmd_filter_s argi[static 1U])
 		}
 	}
 
-	with (const char *fn = *argi->args) {
+	{
 		const bool edgp = argi->edge_flag;
+		const struct step_blk_s *fb;
+		struct step_blk_s *b;
 		coru_t flt;
 		coru_t out;
-		FILE *f;
 
-		if (UNLIKELY((f = fopen(fn, "r")) == NULL)) {
-			error("cannot open time series file `%s'", fn);
+		if (UNLIKELY((b = make_step_blk()) == NULL)) {
 			rc = -1;
 			goto out;
 		}
 
 		init_coru();
 		flt = make_coru(
-			co_tser_flt, q, f,
+			co_tser_flt, q, ts.f, ts.n,
 			.edgp = edgp, .levp = !edgp,
-			.mqa = max_quote_age);
-		out = make_coru(
-			co_echs_out, stdout,
-			argi->rel_flag, argi->abs_flag, argi->oco_flag,
-			.prnt_prcp = true);
+			.mqa = max_quote_age,
+			.from = ft[0U], .till = ft[1U]);
+		if (!argi->binary_flag) {
+			out = make_coru(
+				co_echs_out, wrr,
+				argi->rel_flag, argi->abs_flag, argi->oco_flag,
+				.prnt_prcp = true);
+		} else {
+			out = make_coru(
+				co_echs_bin, wrr,
+				argi->rel_flag, argi->abs_flag, argi->oco_flag);
+			truf_bin_hdr(wrr, TRUF_BIN_STEP_COLS,
+				     sizeof(struct truf_bin_step_s));
+		}
 
-		for (truf_step_cell_t e; (e = next(flt)) != NULL;) {
-			if (UNLIKELY(isnanpx(e->bid))) {
-				continue;
+		while ((fb = next(flt)) != NULL) {
+			for (size_t i = 0U; i < fb->n; i++) {
+				if (UNLIKELY(isnanpx(fb->s[i].bid))) {
+					continue;
+				}
+				step_blk_push(out, b, fb->s + i);
 			}
-			____next(out, e);
 		}
+		step_blk_flush(out, b);
 
 		free_coru(flt);
 		free_coru(out);
 		fini_coru();
-		fclose(f);
+		free_step_blk(b);
 	}
 out:
+	if (UNLIKELY(close_tsers(&ts) < 0)) {
+		rc = -1;
+	}
 	if (LIKELY(q != NULL)) {
 		free_truf_wheap(q);
 	}
@@ -1199,23 +2182,35 @@ cmd_position(const struct yuck_cmd_position_s argi[static 1U])
 	{
 		char *const *dt = argi->args + 1U;
 		const size_t ndt = argi->nargs - 1U;
+		struct step_blk_s *b;
 		coru_t pos;
 		coru_t out;
 
+		if (UNLIKELY((b = make_step_blk()) == NULL)) {
+			rc = -1;
+			goto out;
+		}
+
 		init_coru();
 		pos = make_coru(co_echs_pos, q, (const char*const*)dt, ndt);
 		out = make_coru(
-			co_echs_out, stdout,
+			co_echs_out, wrr,
 			argi->rel_flag, argi->abs_flag, argi->oco_flag,
 			.prnt_expp = true);
 
 		for (truf_step_cell_t e; (e = next(pos)) != NULL;) {
-			____next(out, e);
+			step_blk_push(out, b, e);
+			if (!ndt) {
+				/* stamps come from stdin, don't hold back */
+				step_blk_flush(out, b);
+			}
 		}
+		step_blk_flush(out, b);
 
 		free_coru(pos);
 		free_coru(out);
 		fini_coru();
+		free_step_blk(b);
 	}
 
 out:
@@ -1230,11 +2225,17 @@ static int
 cmd_glue(const struct yuck_cmd_glue_s argi[static 1U])
 {
 	echs_idiff_t max_quote_age;
+	struct tsers_s ts = {0U};
+	echs_instant_t ft[2U];
 	truf_wheap_t q;
 
 	if (argi->nargs < 1U) {
 		yuck_auto_usage((const yuck_t*)argi);
 		return 1;
+	} else if (argi->binary_flag && isatty(STDOUT_FILENO)) {
+		errno = 0, error("\
+Error: refusing to write binary data to a terminal");
+		return 1;
 	} else if (UNLIKELY((q = make_truf_wheap()) == NULL)) {
 		rc = -1;
 		goto out;
@@ -1246,6 +2247,19 @@ cmd_glue(const struct yuck_cmd_glue_s argi[static 1U])
 		max_quote_age = (echs_idiff_t){4095};
 	}
 
+	if (UNLIKELY(rd_from_till(ft, argi->from_arg, argi->till_arg) < 0)) {
+		rc = -1;
+		goto out;
+	} else if (UNLIKELY(open_tsers(
+				    &ts, *argi->args,
+				    argi->merge_args, argi->merge_nargs,
+				    false) < 0)) {
+		rc = -1;
+		goto out;
+	} else if (argi->from_arg) {
+		seek_tsers(&ts, ft[0U]);
+	}
+
 	for (unsigned int i = 1U; i < argi->nargs; i++) {
 		const char *fn = argi->args[i];
 
@@ -1256,37 +2270,42 @@ cmd_glue(const struct yuck_cmd_glue_s argi[static 1U])
 		}
 	}
 
-	with (const char *fn = argi->args[0U]) {
+	{
 		coru_t flt;
 		coru_t out;
-		FILE *f;
-
-		if (UNLIKELY((f = fopen(fn, "r")) == NULL)) {
-			error("cannot open time series file `%s'", fn);
-			rc = -1;
-			goto out;
-		}
 
 		init_coru();
 		flt = make_coru(
-			co_tser_flt, q, f,
+			co_tser_flt, q, ts.f, ts.n,
 			.edgp = true, .levp = !argi->edge_flag,
-			.mqa = max_quote_age);
-		out = make_coru(
-			co_echs_out, stdout,
-			argi->rel_flag, argi->abs_flag, argi->oco_flag,
-			.prnt_expp = true, .prnt_prcp = true);
+			.mqa = max_quote_age,
+			.from = ft[0U], .till = ft[1U]);
+		if (!argi->binary_flag) {
+			out = make_coru(
+				co_echs_out, wrr,
+				argi->rel_flag, argi->abs_flag, argi->oco_flag,
+				.prnt_expp = true, .prnt_prcp = true);
+		} else {
+			out = make_coru(
+				co_echs_bin, wrr,
+				argi->rel_flag, argi->abs_flag, argi->oco_flag);
+			truf_bin_hdr(wrr, TRUF_BIN_STEP_COLS,
+				     sizeof(struct truf_bin_step_s));
+		}
 
-		for (truf_step_cell_t e; (e = next(flt)) != NULL;) {
-			____next(out, e);
+		for (const struct step_blk_s *fb; (fb = next(flt)) != NULL;) {
+			/* pass blocks on as is */
+			____next(out, fb);
 		}
 
 		free_coru(flt);
 		free_coru(out);
 		fini_coru();
-		fclose(f);
 	}
 out:
+	if (UNLIKELY(close_tsers(&ts) < 0)) {
+		rc = -1;
+	}
 	if (LIKELY(q != NULL)) {
 		free_truf_wheap(q);
 	}
@@ -1298,11 +2317,17 @@ static int
 cmd_roll(const struct yuck_cmd_roll_s argi[static 1U])
 {
 	echs_idiff_t max_quote_age;
+	struct tsers_s ts = {0U};
+	echs_instant_t ft[2U];
 	truf_wheap_t q;
 
 	if (argi->nargs < 1U) {
 		yuck_auto_usage((const yuck_t*)argi);
 		return 1;
+	} else if (argi->binary_flag && isatty(STDOUT_FILENO)) {
+		errno = 0, error("\
+Error: refusing to write binary data to a terminal");
+		return 1;
 	} else if (UNLIKELY((q = make_truf_wheap()) == NULL)) {
 		rc = -1;
 		goto out;
@@ -1314,6 +2339,19 @@ cmd_roll(const struct yuck_cmd_roll_s argi[static 1U])
 		max_quote_age = (echs_idiff_t){4095};
 	}
 
+	if (UNLIKELY(rd_from_till(ft, argi->from_arg, argi->till_arg) < 0)) {
+		rc = -1;
+		goto out;
+	} else if (UNLIKELY(open_tsers(
+				    &ts, *argi->args,
+				    argi->merge_args, argi->merge_nargs,
+				    argi->nargs <= 1U) < 0)) {
+		rc = -1;
+		goto out;
+	} else if (argi->from_arg) {
+		seek_tsers(&ts, ft[0U]);
+	}
+
 	for (unsigned int i = 1U; i < argi->nargs + (argi->nargs <= 1U); i++) {
 		const char *fn = argi->args[i];
 
@@ -1324,14 +2362,14 @@ cmd_roll(const struct yuck_cmd_roll_s argi[static 1U])
 		}
 	}
 
-	with (const char *fn = argi->args[0U]) {
+	{
 		truf_price_t prc = NANPX;
 		truf_price_t cfv = 1.df;
 		bool abs_prec_p = false;
 		signed int prec = 0;
+		struct roll_blk_s *ob;
 		coru_t flt;
 		coru_t out;
-		FILE *f;
 		const char *p;
 
 		if ((p = argi->precision_arg)) {
@@ -1349,11 +2387,11 @@ cmd_roll(const struct yuck_cmd_roll_s argi[static 1U])
 				goto out;
 			}
 		}
-		if (UNLIKELY((f = fopen(fn, "r")) == NULL)) {
-			error("cannot open time series file `%s'", fn);
+		if (UNLIKELY((ob = malloc(sizeof(*ob))) == NULL)) {
 			rc = -1;
 			goto out;
 		}
+		ob->n = 0U;
 
 		if (argi->basis_arg) {
 			prc = strtopx(argi->basis_arg, NULL);
@@ -1364,55 +2402,80 @@ cmd_roll(const struct yuck_cmd_roll_s argi[static 1U])
 
 		init_coru();
 		flt = make_coru(
-			co_tser_flt, q, f,
+			co_tser_flt, q, ts.f, ts.n,
 			.edgp = true, .levp = !argi->edge_flag,
-			.mqa = max_quote_age);
-		out = make_coru(
-			co_roll_out, stdout,
-			.absp = abs_prec_p, .prec = prec);
+			.mqa = max_quote_age,
+			.from = ft[0U], .till = ft[1U]);
+		if (!argi->binary_flag) {
+			out = make_coru(
+				co_roll_out, wrr,
+				.absp = abs_prec_p, .prec = prec);
+		} else {
+			out = make_coru(
+				co_roll_bin, wrr,
+				.absp = abs_prec_p, .prec = prec);
+			truf_bin_hdr(wrr, TRUF_BIN_ROLL_COLS,
+				     sizeof(struct truf_bin_roll_s));
+		}
 
-		echs_instant_t metro = {9999U};
+		echs_instant_t metro = {.y = 9999U};
 		coru_args(co_roll_out) oa = {};
-		for (truf_step_cell_t e; (e = next(flt)) != NULL;) {
-			echs_instant_t t = e->t;
-			truf_rpaf_t r = truf_rpaf_step(e);
-
-			if (UNLIKELY(isnanpx(e->bid))) {
-				/* do fuckall */
-				continue;
-			} else if (UNLIKELY(isnanpx(prc))) {
-				/* set initial price level to first refprc */
-				signed int iqu = 0;
-
-				prc = r.refprc;
-				/* get the quantum right for this one */
-				iqu += quantexpd(prc);
-				iqu += quantexpd(r.cruflo);
-				iqu += quantexpd(cfv);
-				prc = quantized(prc, scalbnd(ZEROPX, iqu));
-			} else {
-				/* sum up rpaf */
-				prc += r.cruflo * cfv;
-			}
+		for (const struct step_blk_s *fb; (fb = next(flt)) != NULL;) {
+			for (size_t i = 0U; i < fb->n; i++) {
+				truf_step_cell_t e = fb->s + i;
+				echs_instant_t t = e->t;
+				truf_rpaf_t r = truf_rpaf_step(e);
+
+				if (UNLIKELY(isnanpx(e->bid))) {
+					/* do fuckall */
+					continue;
+				} else if (UNLIKELY(isnanpx(prc))) {
+					/* initial price level is the refprc */
+					signed int iqu = 0;
+
+					prc = r.refprc;
+					/* get the quantum right for this one */
+					iqu += quantexpd(prc);
+					iqu += quantexpd(r.cruflo);
+					iqu += quantexpd(cfv);
+					prc = quantized(
+						prc, scalbnd(ZEROPX, iqu));
+				} else {
+					/* sum up rpaf */
+					prc += r.cruflo * cfv;
+				}
 
-			/* defer by one, to avoid time dupes */
-			if (echs_instant_lt_p(metro, t)) {
-				next_with(out, oa);
+				/* defer by one, to avoid time dupes */
+				if (echs_instant_lt_p(metro, t)) {
+					ob->r[ob->n] = oa;
+					if (UNLIKELY(++ob->n >= NSTEP_BLK)) {
+						____next(out, ob);
+						ob->n = 0U;
+					}
+				}
+				oa = pack_args(
+					co_roll_out,
+					t, prc, r.cruvol, r.cruopi);
+				metro = t;
 			}
-			oa = pack_args(co_roll_out, t, prc, r.cruvol, r.cruopi);
-			metro = t;
 		}
 		/* drain */
 		if (!isnanpx(prc) && rc >= 0) {
-			next_with(out, oa);
+			ob->r[ob->n++] = oa;
+		}
+		if (ob->n) {
+			____next(out, ob);
 		}
 
 		free_coru(flt);
 		free_coru(out);
 		fini_coru();
-		fclose(f);
+		free(ob);
 	}
 out:
+	if (UNLIKELY(close_tsers(&ts) < 0)) {
+		rc = -1;
+	}
 	if (LIKELY(q != NULL)) {
 		free_truf_wheap(q);
 	}
@@ -1423,6 +2486,8 @@ out:
 static int
 cmd_flow(const struct yuck_cmd_flow_s argi[static 1U])
 {
+	struct step_blk_s *b;
+	const char *fn;
 	FILE *f;
 	coru_t rdr;
 	coru_t out;
@@ -1430,54 +2495,182 @@ cmd_flow(const struct yuck_cmd_flow_s argi[static 1U])
 	if (argi->nargs > 1U) {
 		yuck_auto_usage((const yuck_t*)argi);
 		return 1;
+	} else if (argi->binary_flag && isatty(STDOUT_FILENO)) {
+		errno = 0, error("\
+Error: refusing to write binary data to a terminal");
+		return 1;
 	}
 
-	if (!argi->nargs) {
-		/* just keep stdin then */
-		f = stdin;
-	} else with (const char *fn = argi->args[0U]) {
-		if (UNLIKELY((f = fopen(fn, "r")) == NULL)) {
-			error("cannot open time series file `%s'", fn);
-			rc = -1;
-			goto out;
-		}
+	/* no file means stdin */
+	fn = argi->nargs ? argi->args[0U] : "-";
+	if (UNLIKELY((f = truf_fopen(fn)) == NULL)) {
+		error("cannot open time series file `%s'", fn);
+		rc = -1;
+		goto out;
+	}
+
+	if (UNLIKELY((b = make_step_blk()) == NULL)) {
+		rc = -1;
+		goto clo;
 	}
 
 	init_coru();
 	rdr = make_coru(co_tser_rdr, f);
-	out = make_coru(
-		co_echs_out, stdout,
-		argi->rel_flag, argi->abs_flag, argi->oco_flag,
-		.prnt_expp = false, .prnt_prcp = true);
+	if (!argi->binary_flag) {
+		out = make_coru(
+			co_echs_out, wrr,
+			argi->rel_flag, argi->abs_flag, argi->oco_flag,
+			.prnt_expp = false, .prnt_prcp = true);
+	} else {
+		out = make_coru(
+			co_echs_bin, wrr,
+			argi->rel_flag, argi->abs_flag, argi->oco_flag);
+		truf_bin_hdr(wrr, TRUF_BIN_STEP_COLS,
+			     sizeof(struct truf_bin_step_s));
+	}
 
-	for (truf_step_cell_t e; (e = next(rdr)) != NULL;) {
-		/* find e's sym in the step cache */
-		truf_step_t st = truf_step_find(e->sym);
-		struct truf_step_s fe = *e;
+	for (const struct step_blk_s *rb; (rb = next(rdr)) != NULL;) {
+		for (size_t i = 0U; i < rb->n; i++) {
+			truf_step_cell_t e = rb->s + i;
+			/* find e's sym in the step cache */
+			truf_step_t st = truf_step_find(e->sym);
+			struct truf_step_s *fe = b->s + i;
 
-		if (UNLIKELY(isnanpx(st->bid))) {
-			st->bid = e->bid;
-		}
-		if (UNLIKELY(isnanpx(st->ask))) {
-			st->ask = e->ask;
+			if (UNLIKELY(isnanpx(st->bid))) {
+				st->bid = e->bid;
+			}
+			if (UNLIKELY(isnanpx(st->ask))) {
+				st->ask = e->ask;
+			}
+			/* fiddle with the copy to make it cash flows */
+			*fe = *e;
+			fe->bid -= st->bid;
+			fe->ask -= st->ask;
+			/* store last version in step[tm] */
+			*st = *e;
 		}
-		/* fiddle with the local step cell to make it cash flows */
-		fe.bid -= st->bid;
-		fe.ask -= st->ask;
-		/* store last version in step[tm] */
-		*st = *e;
-		next_with(out, fe);
+		/* blocks map 1:1 */
+		b->n = rb->n;
+		____next(out, b);
 	}
 
 	free_coru(rdr);
 	free_coru(out);
 	fini_coru();
-	fclose(f);
+	free_step_blk(b);
+clo:
+	if (UNLIKELY(truf_fclose(f) < 0)) {
+		error("cannot read time series file `%s'", fn);
+		rc = -1;
+	}
+out:
+	return rc < 0;
+}
+
+static int
+cmd_pack(const struct yuck_cmd_pack_s argi[static 1U])
+{
+	truf_pack_t pk;
+	const char *fn;
+	FILE *f;
+	coru_t rdr;
+
+	if (argi->nargs > 1U) {
+		yuck_auto_usage((const yuck_t*)argi);
+		return 1;
+	} else if (isatty(STDOUT_FILENO)) {
+		errno = 0, error("\
+Error: refusing to write binary data to a terminal");
+		return 1;
+	}
+
+	/* no file means stdin */
+	fn = argi->nargs ? argi->args[0U] : "-";
+	if (UNLIKELY((f = truf_fopen(fn)) == NULL)) {
+		error("cannot open time series file `%s'", fn);
+		rc = -1;
+		goto out;
+	}
+
+	if (UNLIKELY((pk = make_truf_pack_wr(stdout)) == NULL)) {
+		error("cannot write packed time series");
+		rc = -1;
+		goto clo;
+	}
+
+	init_coru();
+	rdr = make_coru(co_tser_rdr, f);
+
+	for (const struct step_blk_s *rb; (rb = next(rdr)) != NULL;) {
+		for (size_t i = 0U; i < rb->n; i++) {
+			truf_pack_add(pk, rb->s + i);
+		}
+	}
+
+	free_coru(rdr);
+	fini_coru();
 
+	if (UNLIKELY(free_truf_pack(pk) < 0)) {
+		error("cannot write packed time series");
+		rc = -1;
+	}
+clo:
+	if (UNLIKELY(truf_fclose(f) < 0)) {
+		error("cannot read time series file `%s'", fn);
+		rc = -1;
+	}
 out:
 	return rc < 0;
 }
 
+static int
+cmd_index(const struct yuck_cmd_index_s argi[static 1U])
+{
+	if (argi->nargs < 1U) {
+		yuck_auto_usage((const yuck_t*)argi);
+		return 1;
+	}
+
+	for (size_t i = 0U; i < argi->nargs; i++) {
+		const char *fn = argi->args[i];
+		char *ifn;
+		FILE *f, *idx;
+
+		if (UNLIKELY((f = fopen(fn, "r")) == NULL)) {
+			error("cannot open time series file `%s'", fn);
+			rc = -1;
+			continue;
+		} else if (UNLIKELY(truf_pack_p(f))) {
+			errno = 0, error("\
+Error: cannot index packed time series file `%s'", fn);
+			rc = -1;
+			goto clo;
+		} else if (UNLIKELY((ifn = idx_fn(fn)) == NULL)) {
+			error("cannot write index file for `%s'", fn);
+			rc = -1;
+			goto clo;
+		} else if (UNLIKELY((idx = fopen(ifn, "w")) == NULL)) {
+			error("cannot write index file `%s'", ifn);
+			rc = -1;
+			goto fre;
+		}
+
+		if (UNLIKELY(truf_idx_wr(idx, f) < 0)) {
+			error("cannot write index file `%s'", ifn);
+			rc = -1;
+		}
+		if (UNLIKELY(fclose(idx) < 0)) {
+			error("cannot write index file `%s'", ifn);
+			rc = -1;
+		}
+	fre:
+		free(ifn);
+	clo:
+		fclose(f);
+	}
+	return rc < 0;
+}
+
 static int
 cmd_expcon(const struct yuck_cmd_expcon_s argi[static 1U])
 {
@@ -1546,6 +2739,35 @@ main(int argc, char *argv[])
 		goto out;
 	}
 
+	/* get the readers going */
+	truf_rdr_readahead(argi->read_ahead_flag);
+	trod_cache = argi->trod_cache_flag;
+	trod_strm = argi->sorted_trods_flag;
+	if (argi->reorder_window_arg) {
+		reorder_window = echs_idiff_rd(argi->reorder_window_arg, NULL);
+	}
+	if (argi->output_arg) {
+		/* swap stdout for the output file */
+		const int fl = O_WRONLY | O_CREAT | O_TRUNC;
+		int fd;
+
+		if (UNLIKELY((fd = open(argi->output_arg, fl, 0666)) < 0)) {
+			error("cannot open output file `%s'", argi->output_arg);
+			res = 1;
+			goto out;
+		} else if (UNLIKELY(dup2(fd, STDOUT_FILENO) < 0)) {
+			error("cannot open output file `%s'", argi->output_arg);
+			close(fd);
+			res = 1;
+			goto out;
+		}
+		close(fd);
+	}
+	/* get the writer going */
+	if (UNLIKELY((wrr = make_truf_wrr(STDOUT_FILENO)) == NULL)) {
+		res = 1;
+		goto out;
+	}
 	/* get the coroutines going */
 	init_coru_core();
 	/* initialise our step and rpaf system */
@@ -1582,6 +2804,12 @@ See --help to obtain a list of available commands.");
 	case TRUFFLE_CMD_FLOW:
 		res = cmd_flow((const void*)argi);
 		break;
+	case TRUFFLE_CMD_PACK:
+		res = cmd_pack((const void*)argi);
+		break;
+	case TRUFFLE_CMD_INDEX:
+		res = cmd_index((const void*)argi);
+		break;
 	case TRUFFLE_CMD_EXPCON:
 		res = cmd_expcon((const void*)argi);
 		break;
@@ -1592,6 +2820,11 @@ See --help to obtain a list of available commands.");
 	truf_fini_rpaf();
 	truf_fini_sym();
 
+	if (UNLIKELY(free_truf_wrr(wrr) < 0)) {
+		error("cannot write output");
+		res = 1;
+	}
+
 out:
 	/* just to make sure */
 	fflush(stdout);
@@ -52,12 +52,23 @@
 
 typedef uint_fast32_t rbitset_t;
 
+/* rank and payload side by side, so comparing and swapping cells
+ * touches one cache line, and 16-byte alignment makes sure a cell
+ * never straddles two */
+typedef struct {
+	echs_instant_t c;
+	uintptr_t o;
+} __attribute__((aligned(16))) wcell_t;
+
+/* bulk inserts of at least this many cells are radix sorted */
+#define RADIX_MINN	(1024U)
+
 struct truf_wheap_s {
 	/** number of cells on the heap */
 	size_t n;
 	/** the cells themselves, with < defined by __inst_lt_p() */
-	echs_instant_t *cells;
-	uintptr_t *colours;
+	wcell_t *cells;
+	/** reverse bits, one per cell */
 	rbitset_t *rbits;
 #define RBITS_WIDTH	(sizeof(rbitset_t) * 8U)
 
@@ -66,6 +77,11 @@ struct truf_wheap_s {
 	size_t ndfr;
 	/** allocated size */
 	size_t z;
+
+	/** as long as cells come in chronologically the heap is a plain
+	 * array and cells I to N are popped in order, no sifting needed */
+	bool srtd;
+	size_t i;
 };
 
 
@@ -85,7 +101,6 @@ __wheap_resz(truf_wheap_t h, size_t nu_z)
 	/* round nu_z to multiple of wid */
 	nu_z = ((nu_z - 1U) / RBITS_WIDTH + 1U) * RBITS_WIDTH;
 	h->cells = recalloc(h->cells, h->z, nu_z);
-	h->colours = recalloc(h->colours, h->z, nu_z);
 	h->rbits = recalloc(h->rbits, h->z / RBITS_WIDTH, nu_z / RBITS_WIDTH);
 	h->z = nu_z;
 	return;
@@ -165,13 +180,104 @@ __wheap_cell_sis(truf_wheap_t h, size_t i)
 static inline void
 __wheap_swap(truf_wheap_t h, size_t i, size_t j)
 {
-	/* swap priority data */
+	/* swap priority data and colours in one go */
 	array_swap(h->cells, i, j);
-	/* swap colours too */
-	array_swap(h->colours, i, j);
 	return;
 }
 
+/* sorted mode */
+static inline bool
+__wheap_srtd_p(truf_wheap_t h, echs_instant_t inst)
+{
+/* return true if H is in sorted mode and stays so after appending INST */
+	return h->srtd && (h->n <= h->i ||
+			   !echs_instant_lt_p(inst, h->cells[h->n - 1U].c));
+}
+
+static void
+__wheap_compact(truf_wheap_t h)
+{
+/* move the popped cells [0, I) out of a sorted H */
+	if (h->i > 0U) {
+		const size_t nu = h->n - h->i;
+		const size_t cz = sizeof(*h->cells);
+
+		memmove(h->cells, h->cells + h->i, nu * cz);
+		memset(h->cells + nu, 0, h->i * cz);
+		h->n = nu;
+		h->i = 0U;
+	}
+	return;
+}
+
+static void
+__wheap_unsort(truf_wheap_t h)
+{
+/* leave sorted mode, a sorted array with all rbits 0 is a weak heap
+ * already so all that's left to do is to move the popped cells out */
+	__wheap_compact(h);
+	h->srtd = false;
+	return;
+}
+
+static bool
+__wheap_radix(truf_wheap_t h)
+{
+/* sort all of H's cells (LSD radix sort on instant keys, stable, so
+ * equal instants stay in insertion order) and go back to sorted mode,
+ * return false if there's no memory for that */
+	struct kv_s {
+		uint64_t k;
+		size_t i;
+	} *a, *b;
+	size_t cnt[8U][256U] = {};
+	const size_t n = h->n;
+
+	if (UNLIKELY((a = malloc(2U * n * sizeof(*a))) == NULL)) {
+		return false;
+	}
+	b = a + n;
+	for (size_t i = 0U; i < n; i++) {
+		a[i] = (struct kv_s){echs_instant_key(h->cells[i].c), i};
+		for (size_t j = 0U; j < 8U; j++) {
+			cnt[j][(a[i].k >> (8U * j)) & 0xffU]++;
+		}
+	}
+	for (size_t j = 0U; j < 8U; j++) {
+		size_t sum = 0U;
+
+		if (cnt[j][(a[0U].k >> (8U * j)) & 0xffU] == n) {
+			/* all keys share this byte */
+			continue;
+		}
+		for (size_t x = 0U; x < 256U; x++) {
+			const size_t c = cnt[j][x];
+			cnt[j][x] = sum;
+			sum += c;
+		}
+		for (size_t i = 0U; i < n; i++) {
+			b[cnt[j][(a[i].k >> (8U * j)) & 0xffU]++] = a[i];
+		}
+		with (struct kv_s *tmp = a) {
+			a = b, b = tmp;
+		}
+	}
+	/* B is big enough to hold all cells in new order */
+	with (wcell_t *p = (void*)b) {
+		for (size_t i = 0U; i < n; i++) {
+			p[i] = h->cells[a[i].i];
+		}
+		memcpy(h->cells, p, n * sizeof(*p));
+	}
+	free(a < b ? a : b);
+
+	memset(h->rbits, 0, h->z / RBITS_WIDTH * sizeof(*h->rbits));
+	h->srtd = true;
+	h->i = 0U;
+	h->ndfr = 0U;
+	return true;
+}
+
 /* merging */
 static bool
 __wheapify_mrg(truf_wheap_t h, size_t i, size_t j)
@@ -179,7 +285,7 @@ __wheapify_mrg(truf_wheap_t h, size_t i, size_t j)
 /* aka Merge(i, j) in Edelkamp/Wegener's paper, or join in the improved one */
 	bool res;
 
-	if ((res = echs_instant_lt_p(h->cells[j], h->cells[i]))) {
+	if ((res = echs_instant_lt_p(h->cells[j].c, h->cells[i].c))) {
 		/* swap(pop(idx), idx) */
 		__wheap_swap(h, i, j);
 		/* update bit field */
@@ -246,6 +352,10 @@ __wheapify_dfr(truf_wheap_t h)
 	if (UNLIKELY(h->ndfr == 0U)) {
 		/* say what? */
 		return;
+	} else if (h->ndfr >= RADIX_MINN && h->ndfr >= h->n / 2U &&
+		   __wheap_radix(h)) {
+		/* mostly new cells, sorting them all is cheaper */
+		return;
 	} else if (UNLIKELY((n = h->n - h->ndfr) > h->n)) {
 		/* not sure what happened */
 		h->ndfr = 0U;
@@ -282,17 +392,23 @@ static size_t
 wheap_add_dfr(truf_wheap_t h, echs_instant_t inst, uintptr_t msg)
 {
 	size_t idx;
+	bool srtd;
 
+	if (!(srtd = __wheap_srtd_p(h, inst)) && h->srtd) {
+		__wheap_unsort(h);
+	} else if (srtd && h->i >= h->n / 2U) {
+		/* at least half of it is popped, reclaim that */
+		__wheap_compact(h);
+	}
 	/* check for resize */
 	if (UNLIKELY((idx = h->n) + 1U >= h->z)) {
 		__wheap_resz(h, h->z * 2U);
 	}
 
-	h->cells[idx] = inst;
-	h->colours[idx] = msg;
+	h->cells[idx] = (wcell_t){inst, msg};
 
-	/* we now violate the heap property */
-	h->ndfr++;
+	/* we now violate the heap property, unless we're sorted */
+	h->ndfr += !srtd;
 	h->n++;
 	return idx;
 }
@@ -308,13 +424,27 @@ wheap_add(truf_wheap_t h, echs_instant_t inst, uintptr_t msg)
 		__wheapify_dfr(h);
 	}
 #endif	/* AUTO_FIXUP_BULK_OPS */
+	if (__wheap_srtd_p(h, inst)) {
+		/* just append, reclaim popped cells first if that's
+		 * at least half of them, so steady push/pop doesn't grow H */
+		if (h->i >= h->n / 2U) {
+			__wheap_compact(h);
+		}
+		if (UNLIKELY((idx = h->n) >= h->z)) {
+			__wheap_resz(h, h->z * 2U);
+		}
+		h->cells[idx] = (wcell_t){inst, msg};
+		h->n++;
+		return idx;
+	} else if (h->srtd) {
+		__wheap_unsort(h);
+	}
 	/* check for resize */
 	if (UNLIKELY((idx = h->n) >= h->z)) {
 		__wheap_resz(h, h->z * 2U);
 	}
 
-	h->cells[idx] = inst;
-	h->colours[idx] = msg;
+	h->cells[idx] = (wcell_t){inst, msg};
 	__wheap_void_rbit(h, idx);
 
 	if (idx & 0x1U) {
@@ -332,7 +462,19 @@ wheap_pop(truf_wheap_t h)
 	uintptr_t res;
 	size_t end_idx;
 
-	if (UNLIKELY(h->n == 0U)) {
+	if (h->srtd) {
+		/* array mode */
+		if (UNLIKELY(h->i >= h->n)) {
+			return 0U;
+		}
+		res = h->cells[h->i].o;
+		h->cells[h->i] = (wcell_t){};
+		if (++h->i >= h->n) {
+			/* start over */
+			h->i = h->n = 0U;
+		}
+		return res;
+	} else if (UNLIKELY(h->n == 0U)) {
 		return 0U;
 #if defined AUTO_FIXUP_BULK_OPS
 	} else if (UNLIKELY(h->ndfr > 0U)) {
@@ -341,18 +483,63 @@ wheap_pop(truf_wheap_t h)
 #endif	/* AUTO_FIXUP_BULK_OPS */
 	}
 
-	res = h->colours[0U];
+	res = h->cells[0U].o;
 
 	end_idx = --h->n;
 
 	h->cells[0U] = h->cells[end_idx];
-	h->cells[end_idx] = (echs_instant_t){};
-
-	h->colours[0U] = h->colours[end_idx];
-	h->colours[end_idx] = (uintptr_t)NULL;
+	h->cells[end_idx] = (wcell_t){};
 
 	if (LIKELY(end_idx > 1)) {
 		__wheapify_sift_down(h, 0U);
+	} else if (end_idx == 0U) {
+		/* empty, get back into sorted mode */
+		memset(h->rbits, 0, h->z / RBITS_WIDTH * sizeof(*h->rbits));
+		h->srtd = true;
+	}
+	return res;
+}
+
+static size_t
+wheap_pop_eqr(truf_wheap_t h, uintptr_t *restrict tgt, size_t n)
+{
+	size_t res = 0U;
+
+	if (h->srtd) {
+		/* array mode, the range is contiguous */
+		const size_t i0 = h->i;
+		uint64_t t;
+		size_t i;
+
+		if (UNLIKELY(i0 >= h->n)) {
+			return 0U;
+		}
+		t = h->cells[i0].c.u;
+		for (i = i0; i < h->n && res < n && h->cells[i].c.u == t;
+		     i++, res++) {
+			tgt[res] = h->cells[i].o;
+		}
+		memset(h->cells + i0, 0, res * sizeof(*h->cells));
+		if ((h->i = i) >= h->n) {
+			/* start over */
+			h->i = h->n = 0U;
+		}
+		return res;
+	} else if (UNLIKELY(h->n == 0U)) {
+		return 0U;
+#if defined AUTO_FIXUP_BULK_OPS
+	} else if (UNLIKELY(h->ndfr > 0U)) {
+		/* fix up bulk inserts? */
+		__wheapify_dfr(h);
+#endif	/* AUTO_FIXUP_BULK_OPS */
+	}
+
+	/* heap mode, pop one by one, mind that the last pop might put
+	 * us back into sorted mode */
+	with (const uint64_t t = h->cells[0U].c.u) {
+		while (res < n && h->n > h->i && h->cells[h->i].c.u == t) {
+			tgt[res++] = wheap_pop(h);
+		}
 	}
 	return res;
 }
@@ -360,7 +547,9 @@ wheap_pop(truf_wheap_t h)
 static uintptr_t
 wheap_top(truf_wheap_t h)
 {
-	if (UNLIKELY(h->n == 0U)) {
+	if (h->srtd) {
+		return h->i < h->n ? h->cells[h->i].o : 0U;
+	} else if (UNLIKELY(h->n == 0U)) {
 		return 0U;
 #if defined AUTO_FIXUP_BULK_OPS
 	} else if (UNLIKELY(h->ndfr > 0U)) {
@@ -369,13 +558,15 @@ wheap_top(truf_wheap_t h)
 #endif	/* AUTO_FIXUP_BULK_OPS */
 	}
 
-	return h->colours[0U];
+	return h->cells[0U].o;
 }
 
 static echs_instant_t
 wheap_top_rank(truf_wheap_t h)
 {
-	if (UNLIKELY(h->n == 0U)) {
+	if (h->srtd) {
+		return h->cells[h->i].c;
+	} else if (UNLIKELY(h->n == 0U)) {
 		return (echs_instant_t){};
 #if defined AUTO_FIXUP_BULK_OPS
 	} else if (UNLIKELY(h->ndfr > 0U)) {
@@ -384,7 +575,7 @@ wheap_top_rank(truf_wheap_t h)
 #endif	/* AUTO_FIXUP_BULK_OPS */
 	}
 
-	return h->cells[0U];
+	return h->cells[0U].c;
 }
 
 static void
@@ -392,6 +583,11 @@ wheap_sort(truf_wheap_t h)
 {
 	if (UNLIKELY(h->n == 0U)) {
 		return;
+	} else if (h->srtd) {
+		/* sorted already, just get rid of the popped cells */
+		__wheap_unsort(h);
+		h->srtd = true;
+		return;
 	}
 
 	/* normally WeakHeapify is called first
@@ -432,11 +628,12 @@ make_truf_wheap(void)
 	/* status so far */
 	h->n = 0U;
 	h->ndfr = 0U;
+	h->srtd = true;
+	h->i = 0U;
 	/* minimum size, say, 64 innit? */
 	h->z = 64U;
 
 	h->cells = calloc(h->z, sizeof(*h->cells));
-	h->colours = calloc(h->z, sizeof(*h->colours));
 	h->rbits = calloc(h->z / 8U, sizeof(*h->rbits));
 	return h;
 }
@@ -446,7 +643,6 @@ free_truf_wheap(truf_wheap_t h)
 {
 	free(h->cells);
 	free(h->rbits);
-	free(h->colours);
 	free(h);
 	return;
 }
@@ -469,6 +665,12 @@ truf_wheap_pop(truf_wheap_t h)
 	return wheap_pop(h);
 }
 
+size_t
+truf_wheap_pop_equal_range(truf_wheap_t h, uintptr_t *restrict tgt, size_t n)
+{
+	return wheap_pop_eqr(h, tgt, n);
+}
+
 void
 truf_wheap_add(truf_wheap_t h, echs_instant_t inst, uintptr_t msg)
 {
@@ -50,6 +50,12 @@ extern echs_instant_t truf_wheap_top_rank(truf_wheap_t);
 extern uintptr_t truf_wheap_top(truf_wheap_t);
 extern uintptr_t truf_wheap_pop(truf_wheap_t);
 
+/**
+ * Pop up to N cells that share the top rank into TGT.
+ * Return the number of cells popped. */
+extern size_t
+truf_wheap_pop_equal_range(truf_wheap_t, uintptr_t *restrict tgt, size_t n);
+
 extern void truf_wheap_add(truf_wheap_t, echs_instant_t, uintptr_t);
 
 /**
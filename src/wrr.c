@@ -0,0 +1,124 @@
+/*** wrr.c -- buffered output for echs lines
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <errno.h>
+#include "wrr.h"
+#include "nifty.h"
+
+/* output buffer size */
+#define WRR_BUFZ	(4U * 1024U * 1024U)
+
+struct truf_wrr_s {
+	int fd;
+	/* set when a write failed, further output is discarded */
+	bool errp;
+	/* flush whenever more than LIM bytes are buffered */
+	size_t lim;
+	size_t n;
+	char b[];
+};
+
+
+static void
+wrr_flush(truf_wrr_t w)
+{
+	for (size_t i = 0U; i < w->n && !w->errp;) {
+		ssize_t nwr = write(w->fd, w->b + i, w->n - i);
+
+		if (LIKELY(nwr > 0)) {
+			i += nwr;
+		} else if (nwr < 0 && errno == EINTR) {
+			continue;
+		} else {
+			w->errp = true;
+		}
+	}
+	w->n = 0U;
+	return;
+}
+
+
+truf_wrr_t
+make_truf_wrr(int fd)
+{
+	/* ttys get a line buffer, everyone else the big one */
+	const bool ttyp = isatty(fd);
+	const size_t z = ttyp ? TRUF_WRR_MAXLN : WRR_BUFZ;
+	truf_wrr_t w;
+
+	if (UNLIKELY((w = malloc(sizeof(*w) + z)) == NULL)) {
+		return NULL;
+	}
+	w->fd = fd;
+	w->errp = false;
+	w->lim = ttyp ? 0U : z - TRUF_WRR_MAXLN;
+	w->n = 0U;
+	return w;
+}
+
+int
+free_truf_wrr(truf_wrr_t w)
+{
+	int res;
+
+	wrr_flush(w);
+	res = -(int)w->errp;
+	free(w);
+	return res;
+}
+
+char*
+truf_wrr_buf(truf_wrr_t w)
+{
+	return w->b + w->n;
+}
+
+void
+truf_wrr_adv(truf_wrr_t w, size_t n)
+{
+	if (UNLIKELY((w->n += n) > w->lim)) {
+		wrr_flush(w);
+	}
+	return;
+}
+
+/* wrr.c ends here */
@@ -0,0 +1,69 @@
+/*** wrr.h -- buffered output for echs lines
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of truffle.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_wrr_h_
+#define INCLUDED_wrr_h_
+
+#include <stdlib.h>
+#include <sys/types.h>
+
+/* room guaranteed behind truf_wrr_buf(), enough for one output line */
+#define TRUF_WRR_MAXLN	(256U)
+
+typedef struct truf_wrr_s *truf_wrr_t;
+
+
+/**
+ * Return a buffered writer for file descriptor FD.
+ * Output is collected in a buffer of a couple of megabytes and handed to
+ * write() in one go when it fills up, ttys are written after every line. */
+extern truf_wrr_t make_truf_wrr(int fd);
+
+/**
+ * Flush and free writer W, FD is not closed.
+ * Return -1 if any of W's writes failed, 0 otherwise. */
+extern int free_truf_wrr(truf_wrr_t w);
+
+/**
+ * Return a pointer into W's buffer with at least TRUF_WRR_MAXLN bytes
+ * of room.  Whatever is put there is only committed by truf_wrr_adv(). */
+extern char *truf_wrr_buf(truf_wrr_t w);
+
+/**
+ * Commit N bytes written to the buffer returned by truf_wrr_buf(). */
+extern void truf_wrr_adv(truf_wrr_t w, size_t n);
+
+#endif	/* INCLUDED_wrr_h_ */